@@ -0,0 +1,805 @@
+// toychain_bench: 해시/채굴/UTXO/영속화/JSON 직렬화 hot path 마이크로벤치마크
+//
+// 결과는 한 줄에 하나씩 JSON 객체로 stdout에 출력한다 (릴리스 간 회귀 추적용).
+//   {"bench":"utxo_lookup","ops":100000,"ns_per_op":41.2,"ops_per_sec":24271844.7,...}
+// 노드 코드가 stdout에 남기는 로그는 측정 동안 버린다.
+//
+// 사용법: toychain_bench [--blocks N] [--txs N] [--utxos N] [--addresses N]
+//                        [--difficulty N] [--threads N] [--filter SUBSTR]
+//        toychain_bench --verify
+//   --verify는 측정 대신 선택된 SHA-256 backend(TOYCHAIN_SHA256)의 결과를 OpenSSL과 대조하고,
+//   틀리면 1, 요청한 backend를 이 CPU에서 쓸 수 없으면 77(건너뜀)로 끝난다.
+
+#include "../src/blockchain.h"
+#include "../src/chain_json.h"
+#include "../src/pow.h"
+#include "../src/snapshot.h"
+#include "../src/db/Database.hpp"
+#include <openssl/sha.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct BenchConfig
+{
+    int blocks = 200;
+    int txsPerBlock = 50;
+    int utxos = 100000;
+    int addresses = 1000;
+    int difficulty = 4;
+    unsigned threads = 0;
+    std::string filter;
+};
+
+// 노드 로그를 버리기 위한 출력 버퍼
+class NullBuffer : public std::streambuf
+{
+protected:
+    int overflow(int c) override { return c; }
+};
+
+static std::ostream *results = nullptr;
+static BenchConfig config;
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static bool enabled(const std::string &name)
+{
+    return config.filter.empty() || name.find(config.filter) != std::string::npos;
+}
+
+static void report(const std::string &name, long long ops, double seconds, const std::string &extra = "")
+{
+    double nsPerOp = ops > 0 ? seconds * 1e9 / ops : 0.0;
+    double opsPerSec = seconds > 0 ? ops / seconds : 0.0;
+    std::ostringstream line;
+    line << "{\"bench\":\"" << name << "\""
+         << ",\"ops\":" << ops
+         << ",\"seconds\":" << seconds
+         << ",\"ns_per_op\":" << nsPerOp
+         << ",\"ops_per_sec\":" << opsPerSec
+         << ",\"blocks\":" << config.blocks
+         << ",\"txs_per_block\":" << config.txsPerBlock
+         << ",\"sha256\":\"" << Sha256::backendName() << "\"";
+    if (!extra.empty())
+        line << "," << extra;
+    line << "}";
+    *results << line.str() << std::endl;
+}
+
+// 현재 프로세스의 resident set 크기 (Linux /proc 전용, 그 외에는 0)
+static long long residentBytes()
+{
+    long long pages = 0, resident = 0;
+    FILE *f = std::fopen("/proc/self/statm", "r");
+    if (!f)
+        return 0;
+    if (std::fscanf(f, "%lld %lld", &pages, &resident) != 2)
+        resident = 0;
+    std::fclose(f);
+    return resident * 4096;
+}
+
+static std::string addressName(int i)
+{
+    return "addr" + std::to_string(i);
+}
+
+static Hash256 syntheticHash(std::mt19937_64 &rng)
+{
+    Hash256 h;
+    for (size_t i = 0; i < h.bytes.size(); i += 8)
+    {
+        uint64_t v = rng();
+        std::memcpy(h.data() + i, &v, sizeof(v));
+    }
+    return h;
+}
+
+// coinbase 형태(outputIndex -1 dummy input)의 트랜잭션만 담은 블록. UTXO 검증을 항상 통과한다.
+static std::vector<UTXOTransaction> syntheticTxs(std::mt19937_64 &rng, int count)
+{
+    std::vector<UTXOTransaction> txs;
+    txs.reserve(count);
+    for (int t = 0; t < count; ++t)
+    {
+        std::vector<TxInput> ins{TxInput(syntheticHash(rng), -1, "bench")};
+        std::vector<TxOutput> outs{TxOutput(1.0 + (rng() % 100), addressName(static_cast<int>(rng() % config.addresses))),
+                                   TxOutput(0.5, addressName(static_cast<int>(rng() % config.addresses)))};
+        txs.emplace_back(ins, outs);
+    }
+    return txs;
+}
+
+static std::vector<Block> syntheticBlocks(const Block &parent, int count, int txsPerBlock, std::mt19937_64 &rng)
+{
+    std::vector<Block> blocks;
+    blocks.reserve(count);
+    Hash256 prev = parent.getHash();
+    for (int b = 0; b < count; ++b)
+    {
+        Block block(parent.getIndex() + 1 + b, 1700000000LL + b, syntheticTxs(rng, txsPerBlock), prev, b, 1);
+        prev = block.getHash();
+        blocks.push_back(block);
+    }
+    return blocks;
+}
+
+static void benchHeaderHash(std::mt19937_64 &rng)
+{
+    Block block(1, syntheticTxs(rng, config.txsPerBlock), Hash256());
+    BlockHasher hasher(block);
+    const int ops = std::max(256, 2000000 / (config.txsPerBlock + 1));
+
+    if (enabled("header_hash_single"))
+    {
+        size_t sink = 0;
+        auto start = Clock::now();
+        for (int n = 0; n < ops; ++n)
+            sink += hasher.hashAt(n).bytes[0];
+        report("header_hash_single", ops, secondsSince(start), "\"sink\":" + std::to_string(sink % 2));
+    }
+
+    if (enabled("header_hash_range"))
+    {
+        Hash256 out[ParallelMiner::BATCH];
+        size_t sink = 0;
+        auto start = Clock::now();
+        for (int n = 0; n < ops; n += ParallelMiner::BATCH)
+        {
+            hasher.hashRange(n, ParallelMiner::BATCH, out);
+            sink += out[0].bytes[0];
+        }
+        int done = (ops + ParallelMiner::BATCH - 1) / ParallelMiner::BATCH * ParallelMiner::BATCH;
+        report("header_hash_range", done, secondsSince(start), "\"sink\":" + std::to_string(sink % 2));
+    }
+}
+
+static void benchNonceSearch()
+{
+    if (!enabled("nonce_search"))
+        return;
+
+    // 여러 블록을 실제로 채굴하고, 찾은 nonce 합을 시도 횟수로 본다
+    const int rounds = 8;
+    long long attempts = 0;
+    std::mt19937_64 rng(42);
+    auto start = Clock::now();
+    for (int r = 0; r < rounds; ++r)
+    {
+        Block block(r + 1, syntheticTxs(rng, config.txsPerBlock), Hash256());
+        block.mineBlock(config.difficulty, nullptr, config.threads);
+        attempts += block.getNonce() + 1LL;
+    }
+    ParallelMiner miner(config.threads);
+    report("nonce_search", attempts, secondsSince(start),
+           "\"difficulty\":" + std::to_string(config.difficulty) + ",\"threads\":" + std::to_string(miner.getThreadCount()));
+}
+
+// 채굴 콜백이 샘플을 남기는 비용: 문자열 vector 앞을 지우며 100개로 자르기 vs 고정 크기 링
+static void benchMiningSamples()
+{
+    if (!enabled("mining_samples_legacy") && !enabled("mining_samples"))
+        return;
+
+    const int ops = 1000000;
+    const size_t history = 100;
+    std::mt19937_64 rng(42);
+    std::vector<Hash256> hashes;
+    for (int i = 0; i < 64; ++i)
+        hashes.push_back(syntheticHash(rng));
+
+    if (enabled("mining_samples_legacy"))
+    {
+        std::vector<std::string> attempts;
+        auto start = Clock::now();
+        for (int n = 0; n < ops; ++n)
+        {
+            attempts.push_back(std::to_string(n) + ":" + hashes[n % hashes.size()].toHex());
+            if (attempts.size() > history)
+                attempts.erase(attempts.begin());
+        }
+        report("mining_samples_legacy", ops, secondsSince(start));
+    }
+    if (enabled("mining_samples"))
+    {
+        SampleRing ring(history);
+        auto start = Clock::now();
+        for (int n = 0; n < ops; ++n)
+            ring.push({n, hashes[n % hashes.size()]});
+        report("mining_samples", ops, secondsSince(start));
+    }
+}
+
+static void benchUTXO(std::mt19937_64 &rng, const std::filesystem::path &dir)
+{
+    std::vector<Hash256> ids;
+    ids.reserve(config.utxos);
+    for (int i = 0; i < config.utxos; ++i)
+        ids.push_back(syntheticHash(rng));
+
+    UTXOSet set;
+    long long rssBefore = residentBytes();
+    auto start = Clock::now();
+    for (int i = 0; i < config.utxos; ++i)
+    {
+        set.addUTXO(OutPoint(ids[i], i % 4), TxOutput(1.0, addressName(i % config.addresses)));
+    }
+    if (enabled("utxo_add"))
+    {
+        double seconds = secondsSince(start);
+        report("utxo_add", config.utxos, seconds,
+               "\"utxos\":" + std::to_string(config.utxos) +
+                   ",\"table_bytes\":" + std::to_string(set.memoryUsage()) +
+                   ",\"rss_delta_bytes\":" + std::to_string(residentBytes() - rssBefore));
+    }
+
+    if (enabled("utxo_lookup"))
+    {
+        size_t hits = 0;
+        start = Clock::now();
+        for (int i = 0; i < config.utxos; ++i)
+        {
+            int j = static_cast<int>(rng() % config.utxos);
+            hits += set.hasUTXO(OutPoint(ids[j], j % 4)) ? 1 : 0;
+        }
+        report("utxo_lookup", config.utxos, secondsSince(start), "\"utxos\":" + std::to_string(config.utxos) + ",\"hits\":" + std::to_string(hits));
+    }
+
+    if (enabled("utxo_balance"))
+    {
+        const int queries = std::min(config.addresses, 200);
+        double total = 0;
+        start = Clock::now();
+        for (int q = 0; q < queries; ++q)
+            total += set.getBalance(addressName(q));
+        report("utxo_balance", queries, secondsSince(start), "\"utxos\":" + std::to_string(config.utxos) + ",\"total\":" + std::to_string(total));
+    }
+
+    if (enabled("utxo_for_address"))
+    {
+        const int queries = std::min(config.addresses, 200);
+        size_t found = 0;
+        start = Clock::now();
+        for (int q = 0; q < queries; ++q)
+            found += set.getUTXOsForAddress(addressName(q)).size();
+        report("utxo_for_address", queries, secondsSince(start), "\"utxos\":" + std::to_string(config.utxos) + ",\"found\":" + std::to_string(found));
+    }
+
+    if (enabled("snapshot"))
+    {
+        // 체인을 바꾸는 스레드가 치르는 비용은 복사뿐이고, 직렬화와 파일 쓰기는 백그라운드에서 한다
+        const std::string snapshotPath = (dir / "utxo.snapshot").string();
+        start = Clock::now();
+        UTXOSet frozen = set;
+        if (enabled("snapshot_copy"))
+            report("snapshot_copy", config.utxos, secondsSince(start), "\"utxos\":" + std::to_string(config.utxos));
+
+        start = Clock::now();
+        bool ok = UTXOSnapshotter::write(snapshotPath, frozen, 1, Hash256{});
+        if (enabled("snapshot_write"))
+            report("snapshot_write", config.utxos, secondsSince(start),
+                   std::string("\"ok\":") + (ok ? "true" : "false") + ",\"bytes\":" + std::to_string(std::filesystem::file_size(snapshotPath)));
+
+        if (enabled("snapshot_load"))
+        {
+            UTXOSnapshotter snapshotter(snapshotPath);
+            UTXOSet loaded;
+            uint64_t height = 0;
+            Hash256 tip{};
+            start = Clock::now();
+            ok = snapshotter.load(loaded, height, tip);
+            report("snapshot_load", config.utxos, secondsSince(start),
+                   std::string("\"ok\":") + (ok && loaded.size() == set.size() ? "true" : "false"));
+        }
+    }
+
+    if (enabled("utxo_remove"))
+    {
+        start = Clock::now();
+        for (int i = 0; i < config.utxos; ++i)
+            set.removeUTXO(OutPoint(ids[i], i % 4));
+        report("utxo_remove", config.utxos, secondsSince(start), "\"utxos\":" + std::to_string(config.utxos));
+    }
+}
+
+static void benchMempool()
+{
+    if (!enabled("mempool_admission"))
+        return;
+
+    // alice에게 블록 보상 UTXO를 blocks개 쌓은 뒤, UTXO 하나씩 쓰는 송금을 mempool에 넣는다
+    Blockchain chain;
+    chain.setDifficulty(1);
+    chain.setDifficultyAdjustmentInterval(1 << 30);
+    chain.setMiningThreads(1);
+    for (int b = 0; b < config.blocks; ++b)
+        chain.minePendingTransactions("alice");
+
+    std::string error;
+    int admitted = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < config.blocks; ++i)
+    {
+        if (chain.addTransaction("alice", addressName(i % config.addresses), 1.0, error))
+            admitted++;
+    }
+    report("mempool_admission", admitted, secondsSince(start), "\"pending\":" + std::to_string(chain.snapshot()->pendingCount));
+}
+
+static void benchChainOps(std::mt19937_64 &rng, const std::filesystem::path &dir)
+{
+    Blockchain chain;
+    // 블록 생성(tx id/해시 계산)은 측정에서 뺀다
+    auto blocks = syntheticBlocks(chain.getLatestBlock(), config.blocks, config.txsPerBlock, rng);
+    auto start = Clock::now();
+    for (const auto &block : blocks)
+        chain.acceptExternalBlock(block);
+    if (enabled("block_accept"))
+        report("block_accept", config.blocks, secondsSince(start), "\"height\":" + std::to_string(chain.getChain().size()));
+
+    if (enabled("chain_validate"))
+    {
+        start = Clock::now();
+        bool valid = chain.isChainValid();
+        report("chain_validate", static_cast<long long>(chain.getChain().size()), secondsSince(start), std::string("\"valid\":") + (valid ? "true" : "false"));
+    }
+
+    const std::string statePath = (dir / "chain.dat").string();
+    if (enabled("state_save") || enabled("state_load"))
+    {
+        start = Clock::now();
+        chain.saveToFile(statePath);
+        if (enabled("state_save"))
+            report("state_save", static_cast<long long>(chain.getChain().size()), secondsSince(start),
+                   "\"bytes\":" + std::to_string(std::filesystem::file_size(statePath)));
+    }
+
+    if (enabled("state_load"))
+    {
+        Blockchain loaded;
+        start = Clock::now();
+        bool ok = loaded.loadFromFile(statePath);
+        report("state_load", static_cast<long long>(loaded.getChain().size()), secondsSince(start), std::string("\"ok\":") + (ok ? "true" : "false"));
+    }
+
+    const std::string logPath = (dir / "chain.log").string();
+    if (enabled("blocklog"))
+    {
+        // 블록마다 fsync하지 않는 설정 (BLOCKLOG_SYNC_EVERY=0)으로 append 비용만 잰다
+        BlockLog log(logPath, 0);
+        MappedBlocks unused;
+        int unusedDifficulty = 0;
+        log.load(unused, unusedDifficulty);
+        start = Clock::now();
+        for (const auto &block : chain.getChain())
+            log.appendBlock(block);
+        log.sync();
+        if (enabled("blocklog_append"))
+            report("blocklog_append", static_cast<long long>(chain.getChain().size()), secondsSince(start),
+                   "\"bytes\":" + std::to_string(std::filesystem::file_size(logPath)));
+    }
+
+    if (enabled("blocklog_open"))
+    {
+        // 매핑과 레코드 위치 수집만 (UTXO 재구성 제외)
+        BlockLog log(logPath);
+        MappedBlocks mapped;
+        int unusedDifficulty = 0;
+        start = Clock::now();
+        bool ok = log.load(mapped, unusedDifficulty);
+        report("blocklog_open", static_cast<long long>(mapped.offsets.size()), secondsSince(start), std::string("\"ok\":") + (ok ? "true" : "false"));
+    }
+
+    if (enabled("blocklog_load"))
+    {
+        BlockLog log(logPath);
+        Blockchain loaded;
+        start = Clock::now();
+        bool ok = loaded.loadFromLog(log);
+        report("blocklog_load", static_cast<long long>(loaded.getChain().size()), secondsSince(start), std::string("\"ok\":") + (ok ? "true" : "false"));
+    }
+
+    if (enabled("sqlite_insert_block"))
+    {
+        Database db((dir / "bench.db").string());
+        start = Clock::now();
+        for (const auto &block : chain.getChain())
+            db.insertBlock(block, block.getTransactions());
+        report("sqlite_insert_block", static_cast<long long>(chain.getChain().size()), secondsSince(start));
+    }
+
+    if (enabled("sqlite_mempool_add"))
+    {
+        // 트랜잭션 하나가 들어올 때마다 mempool 테이블에 쓰는 비용 (mempool이 커져도 일정해야 한다)
+        Database db((dir / "mempool.db").string());
+        auto pending = syntheticTxs(rng, config.txsPerBlock);
+        start = Clock::now();
+        for (const auto &tx : pending)
+            db.insertMempool({tx});
+        report("sqlite_mempool_add", static_cast<long long>(pending.size()), secondsSince(start),
+               "\"stored\":" + std::to_string(db.loadMempool().size()));
+    }
+
+    if (enabled("block_accept_persisted"))
+    {
+        // 블록 로그(블록마다 fsync) + SQLite를 persistence 스레드에 맡긴 채 받아들이는 비용.
+        // ops/ns_per_op는 호출자가 기다린 시간, durable_seconds는 모두 디스크에 기록될 때까지
+        const std::string persistLogPath = (dir / "persist.log").string();
+        BlockLog log(persistLogPath, 1);
+        Database db((dir / "persist.db").string());
+        Blockchain persisted;
+        persisted.loadFromLog(log);
+        persisted.writeToLog(log);
+        PersistencePipeline persistence(&log, &db, nullptr);
+        persisted.attachPersistence(&persistence);
+
+        start = Clock::now();
+        for (const auto &block : blocks)
+            persisted.acceptExternalBlock(block);
+        double callerSeconds = secondsSince(start);
+        bool durable = persisted.waitDurable();
+        report("block_accept_persisted", config.blocks, callerSeconds,
+               "\"durable_seconds\":" + std::to_string(secondsSince(start)) + ",\"durable\":" + (durable ? "true" : "false"));
+    }
+}
+
+// JsonWriter 이전 서버의 stringstream 직렬화 (json_* 벤치의 비교 기준)
+static std::string legacyTxJson(const UTXOTransaction &tx)
+{
+    std::stringstream ss;
+    ss << "{\"id\":\"" << tx.getId().toHex() << "\",\"inputs\":[";
+    const auto &inputs = tx.getInputs();
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        ss << "{\"txId\":\"" << inputs[i].txId.toHex() << "\",\"outputIndex\":" << inputs[i].outputIndex
+           << ",\"signature\":\"" << inputs[i].signature << "\"}";
+        if (i < inputs.size() - 1)
+            ss << ",";
+    }
+    ss << "],\"outputs\":[";
+    const auto &outs = tx.getOutputs();
+    for (size_t i = 0; i < outs.size(); ++i)
+    {
+        ss << "{\"address\":\"" << outs[i].address << "\",\"amount\":" << outs[i].amount << "}";
+        if (i < outs.size() - 1)
+            ss << ",";
+    }
+    ss << "]}";
+    return ss.str();
+}
+
+static std::string legacyBlockJson(const Block &b)
+{
+    std::stringstream ss;
+    ss << "{\"index\":" << b.getIndex() << ",\"timestamp\":" << b.getTimestamp()
+       << ",\"previousHash\":\"" << b.getPreviousHash().toHex() << "\",\"hash\":\"" << b.getHash().toHex()
+       << "\",\"nonce\":" << b.getNonce() << ",\"difficulty\":" << b.getDifficulty() << ",\"transactions\":[";
+    const auto &txs = b.getTransactions();
+    for (size_t i = 0; i < txs.size(); ++i)
+    {
+        ss << legacyTxJson(txs[i]);
+        if (i < txs.size() - 1)
+            ss << ",";
+    }
+    ss << "]}";
+    return ss.str();
+}
+
+static std::string legacyUtxoJson(const std::vector<std::pair<OutPoint, TxOutput>> &utxos)
+{
+    std::string body = "[";
+    for (size_t i = 0; i < utxos.size(); ++i)
+    {
+        const auto &[outPoint, output] = utxos[i];
+        body += "{";
+        body += "\"txId\":\"" + outPoint.txId.toHex() + "\",";
+        body += "\"index\":" + std::to_string(outPoint.index) + ",";
+        body += "\"address\":\"" + output.address + "\",";
+        body += "\"amount\":" + std::to_string(output.amount);
+        body += "}";
+        if (i < utxos.size() - 1)
+            body += ",";
+    }
+    body += "]";
+    return body;
+}
+
+static std::string throughput(size_t bytes, double seconds)
+{
+    return "\"bytes\":" + std::to_string(bytes) + ",\"mb_per_sec\":" + std::to_string(seconds > 0 ? bytes / seconds / 1e6 : 0.0);
+}
+
+static void benchJson(std::mt19937_64 &rng)
+{
+    if (!enabled("json_block_legacy") && !enabled("json_block") && !enabled("json_parse_block") &&
+        !enabled("json_utxos_legacy") && !enabled("json_utxos"))
+        return;
+
+    Block genesis(0, {}, Hash256());
+    std::vector<Block> blocks = syntheticBlocks(genesis, config.blocks, config.txsPerBlock, rng);
+    const int rounds = std::max(1, 100000 / (config.blocks * config.txsPerBlock)); // 트랜잭션 10만 개쯤
+
+    // 블록 전체: 블록마다 새 문자열 vs 응답 버퍼 하나를 비워 가며 재사용
+    if (enabled("json_block_legacy"))
+    {
+        size_t bytes = 0;
+        auto start = Clock::now();
+        for (int r = 0; r < rounds; ++r)
+            for (const auto &block : blocks)
+                bytes += legacyBlockJson(block).size();
+        double seconds = secondsSince(start);
+        report("json_block_legacy", (long long)rounds * config.blocks, seconds, throughput(bytes, seconds));
+    }
+    if (enabled("json_block"))
+    {
+        std::string out;
+        size_t bytes = 0;
+        auto start = Clock::now();
+        for (int r = 0; r < rounds; ++r)
+            for (const auto &block : blocks)
+            {
+                out.clear();
+                JsonWriter(out).value(block);
+                bytes += out.size();
+            }
+        double seconds = secondsSince(start);
+        report("json_block", (long long)rounds * config.blocks, seconds, throughput(bytes, seconds));
+    }
+
+    // 피어 블록 수신: 본문 하나를 훑어 Block을 만든다
+    if (enabled("json_parse_block"))
+    {
+        std::vector<std::string> bodies;
+        size_t bytes = 0;
+        for (const auto &block : blocks)
+        {
+            bodies.push_back(toJson(block));
+            bytes += bodies.back().size();
+        }
+        size_t txs = 0;
+        auto start = Clock::now();
+        for (int r = 0; r < rounds; ++r)
+            for (const auto &body : bodies)
+                txs += parseBlockJson(body).getTransactions().size();
+        double seconds = secondsSince(start);
+        report("json_parse_block", (long long)rounds * config.blocks, seconds, throughput(bytes * rounds, seconds));
+        if (txs != (size_t)rounds * config.blocks * config.txsPerBlock)
+            std::cerr << "⚠️ json_parse_block: parsed " << txs << " transactions\n";
+    }
+
+    // UTXO 목록 (/utxos 응답 하나)
+    std::vector<std::pair<OutPoint, TxOutput>> utxos;
+    utxos.reserve(config.utxos);
+    for (int i = 0; i < config.utxos; ++i)
+        utxos.emplace_back(OutPoint(syntheticHash(rng), i % 4), TxOutput(1.0 + (rng() % 1000) / 8.0, addressName(i % config.addresses)));
+
+    if (enabled("json_utxos_legacy"))
+    {
+        auto start = Clock::now();
+        size_t bytes = legacyUtxoJson(utxos).size();
+        double seconds = secondsSince(start);
+        report("json_utxos_legacy", config.utxos, seconds, throughput(bytes, seconds));
+    }
+    if (enabled("json_utxos"))
+    {
+        auto start = Clock::now();
+        std::string out;
+        JsonWriter(out).array(utxos);
+        double seconds = secondsSince(start);
+        report("json_utxos", config.utxos, seconds, throughput(out.size(), seconds));
+    }
+}
+
+// TOYCHAIN_SHA256 값 → 그 backend가 선택됐을 때의 Sha256::backendName()
+static const char *expectedBackend(const std::string &requested)
+{
+    if (requested == "scalar")
+        return "scalar";
+    if (requested == "shani")
+        return "sha-ni";
+    if (requested == "sse4")
+        return "sse4.1x4";
+    if (requested == "avx2")
+        return "avx2x8";
+    if (requested == "avx512")
+        return "avx512x16";
+    return nullptr;
+}
+
+// 합의에 쓰이는 해시이므로 backend의 lane 커널을 고치면 이것으로 확인한다.
+// 길이 0~299 메시지를 한 번에, lane마다 길이를 섞어, midstate에서 이어서 해시하고 OpenSSL SHA256과 비교한다.
+// 채굴(hashRange)과 체인 검증(hashBlocks) 경로는 단일 버퍼 해시와 같은 값을 내는지 본다.
+static int verifySha256()
+{
+    const char *forced = std::getenv("TOYCHAIN_SHA256");
+    const std::string requested = forced ? forced : "";
+    const char *expected = expectedBackend(requested);
+    if (expected && std::strcmp(expected, Sha256::backendName()) != 0)
+    {
+        std::cout << "{\"verify\":\"sha256\",\"requested\":\"" << requested << "\",\"backend\":\"" << Sha256::backendName()
+                  << "\",\"status\":\"skipped\"}" << std::endl;
+        return 77;
+    }
+
+    const size_t MAX_LEN = 300;
+    std::mt19937_64 rng(2024);
+    std::vector<std::string> messages(MAX_LEN);
+    std::vector<Hash256> expectedHashes(MAX_LEN);
+    for (size_t len = 0; len < MAX_LEN; ++len)
+    {
+        for (size_t i = 0; i < len; ++i)
+            messages[len] += static_cast<char>(rng());
+        SHA256(reinterpret_cast<const unsigned char *>(messages[len].data()), len, expectedHashes[len].data());
+    }
+
+    long long checks = 0, failures = 0;
+    auto check = [&](const char *path, size_t len, const Hash256 &got, const Hash256 &want)
+    {
+        ++checks;
+        if (got == want)
+            return;
+        if (++failures <= 10)
+            std::cerr << "❌ sha256 " << Sha256::backendName() << " " << path << " len " << len << ": " << got.toHex()
+                      << " != " << want.toHex() << "\n";
+    };
+
+    // 단일 버퍼 (스트리밍)
+    for (size_t len = 0; len < MAX_LEN; ++len)
+    {
+        Hash256 h;
+        Sha256::hash(messages[len].data(), len, h.data());
+        check("hash", len, h, expectedHashes[len]);
+    }
+
+    // multi-buffer: 길이가 다른 메시지가 같은 묶음의 lane에 섞인다
+    std::vector<std::string_view> views(messages.begin(), messages.end());
+    std::vector<Hash256> out(MAX_LEN);
+    Sha256::hashMany(views.data(), views.size(), out.data());
+    for (size_t len = 0; len < MAX_LEN; ++len)
+        check("hashMany", len, out[len], expectedHashes[len]);
+
+    // lane마다 다른 midstate (앞부분을 update한 뒤 나머지를 finishMany)
+    for (size_t split : {1, 55, 63, 64, 65, 119, 128, 200})
+    {
+        std::vector<Sha256> bases;
+        std::vector<std::string_view> tails;
+        std::vector<size_t> lengths;
+        for (size_t len = 0; len < MAX_LEN; ++len)
+        {
+            const size_t cut = std::min(len, split + len % 7);
+            Sha256 base;
+            base.update(messages[len].data(), cut);
+            bases.push_back(base);
+            tails.push_back(std::string_view(messages[len]).substr(cut));
+            lengths.push_back(len);
+        }
+        Sha256::finishMany(bases.data(), tails.data(), bases.size(), out.data());
+        for (size_t i = 0; i < lengths.size(); ++i)
+            check("finishMany", lengths[i], out[i], expectedHashes[lengths[i]]);
+    }
+
+    // 하나의 midstate에서 갈라지는 메시지 (같은 앞부분 + 서로 다른 뒷부분)
+    for (size_t split : {0, 10, 64, 100})
+    {
+        Sha256 base;
+        base.update(messages[MAX_LEN - 1].data(), split);
+        std::vector<std::string> whole;
+        std::vector<std::string_view> tails;
+        for (size_t len = 0; len + split < MAX_LEN; ++len)
+        {
+            whole.push_back(messages[MAX_LEN - 1].substr(0, split) + messages[len]);
+            tails.push_back(messages[len]);
+        }
+        base.finishMany(tails.data(), tails.size(), out.data());
+        for (size_t i = 0; i < whole.size(); ++i)
+        {
+            Hash256 want;
+            SHA256(reinterpret_cast<const unsigned char *>(whole[i].data()), whole[i].size(), want.data());
+            check("finishMany(midstate)", whole[i].size(), out[i], want);
+        }
+    }
+
+    // 채굴과 체인 검증 경로
+    Block genesis(0, {}, Hash256());
+    for (int txs : {1, 3, 20})
+    {
+        std::vector<Block> blocks = syntheticBlocks(genesis, 4, txs, rng);
+        BlockHasher hasher(blocks[0]);
+        const int first = 99990; // 자릿수가 5 → 6으로 넘어가는 구간
+        Hash256 range[ParallelMiner::BATCH];
+        hasher.hashRange(first, ParallelMiner::BATCH, range);
+        for (int i = 0; i < ParallelMiner::BATCH; ++i)
+            check("hashRange", (size_t)txs, range[i], hasher.hashAt(first + i));
+
+        std::vector<const Block *> ptrs;
+        for (const auto &block : blocks)
+            ptrs.push_back(&block);
+        std::vector<Hash256> hashes(blocks.size());
+        BlockHasher::hashBlocks(ptrs.data(), ptrs.size(), hashes.data());
+        for (size_t i = 0; i < blocks.size(); ++i)
+            check("hashBlocks", (size_t)txs, hashes[i], blocks[i].calculateHash());
+    }
+
+    std::cout << "{\"verify\":\"sha256\",\"requested\":\"" << requested << "\",\"backend\":\"" << Sha256::backendName()
+              << "\",\"checks\":" << checks << ",\"failures\":" << failures << ",\"status\":\""
+              << (failures == 0 ? "ok" : "failed") << "\"}" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
+
+static void usage()
+{
+    std::cerr << "usage: toychain_bench [--blocks N] [--txs N] [--utxos N] [--addresses N]"
+                 " [--difficulty N] [--threads N] [--filter SUBSTR]\n"
+                 "       toychain_bench --verify\n";
+}
+
+int main(int argc, char **argv)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--verify")
+            return verifySha256();
+        if (i + 1 >= argc)
+        {
+            usage();
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--blocks")
+            config.blocks = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--txs")
+            config.txsPerBlock = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--utxos")
+            config.utxos = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--addresses")
+            config.addresses = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--difficulty")
+            config.difficulty = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--threads")
+            config.threads = static_cast<unsigned>(std::atoi(value.c_str()));
+        else if (arg == "--filter")
+            config.filter = value;
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    auto dir = std::filesystem::temp_directory_path() / ("toychain_bench_" + std::to_string(std::random_device{}()));
+    std::filesystem::create_directories(dir);
+
+    // 결과 줄만 원래 stdout으로, 나머지 로그는 버린다
+    std::ostream out(std::cout.rdbuf());
+    results = &out;
+    NullBuffer discard;
+    std::cout.rdbuf(&discard);
+
+    std::mt19937_64 rng(1234);
+    benchHeaderHash(rng);
+    benchNonceSearch();
+    benchMiningSamples();
+    benchUTXO(rng, dir);
+    benchMempool();
+    benchChainOps(rng, dir);
+    benchJson(rng);
+
+    std::cout.rdbuf(out.rdbuf());
+    std::filesystem::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,109 @@
+#ifndef APPEND_VECTOR_H
+#define APPEND_VECTOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// writer 하나가 뒤에 붙이고 여러 reader가 동시에 읽는 배열.
+// 원소는 고정 크기 segment에 들어가 주소가 바뀌지 않으므로, reader는 size()로 본 개수 안쪽을
+// 잠금 없이 읽어도 writer의 emplace_back과 겹치지 않는다.
+// segment 목록이 꽉 차면 두 배 크기의 새 목록을 발행하고 예전 목록은 소멸할 때까지 남겨 둔다
+// (예전 목록을 들고 있는 reader도 그대로 읽을 수 있다). clear()와 소멸은 reader가 없을 때만 한다.
+template <typename T, size_t SEGMENT_BITS = 10>
+class AppendVector
+{
+public:
+    static constexpr size_t SEGMENT_SIZE = size_t(1) << SEGMENT_BITS;
+
+    AppendVector() = default;
+    ~AppendVector() { clear(); }
+
+    AppendVector(const AppendVector &) = delete;
+    AppendVector &operator=(const AppendVector &) = delete;
+
+    size_t size() const { return count.load(std::memory_order_acquire); }
+    bool empty() const { return size() == 0; }
+
+    const T &operator[](size_t i) const { return *slot(i); }
+    T &operator[](size_t i) { return *slot(i); }
+    const T &back() const { return *slot(size() - 1); }
+
+    template <typename... Args>
+    T &emplace_back(Args &&...args)
+    {
+        const size_t n = count.load(std::memory_order_relaxed);
+        const size_t seg = n >> SEGMENT_BITS;
+        Directory *dir = directory.load(std::memory_order_relaxed);
+        if (!dir || seg == dir->capacity)
+            dir = grow(dir);
+        if (!dir->segments[seg])
+            dir->segments[seg] = static_cast<Storage *>(::operator new(sizeof(Storage) * SEGMENT_SIZE));
+
+        T *item = new (&dir->segments[seg][n & (SEGMENT_SIZE - 1)]) T(std::forward<Args>(args)...);
+        // 원소를 다 만든 뒤에 개수를 늘려야 reader가 덜 만들어진 원소를 보지 않는다
+        count.store(n + 1, std::memory_order_release);
+        return *item;
+    }
+
+    void push_back(const T &value) { emplace_back(value); }
+    void push_back(T &&value) { emplace_back(std::move(value)); }
+
+    void clear()
+    {
+        const size_t n = count.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < n; ++i)
+            slot(i)->~T();
+        if (Directory *dir = directory.load(std::memory_order_relaxed))
+        {
+            for (size_t s = 0; s < dir->capacity; ++s)
+                ::operator delete(dir->segments[s]);
+        }
+        directories.clear();
+        directory.store(nullptr, std::memory_order_relaxed);
+        count.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+    struct Directory
+    {
+        size_t capacity;
+        std::unique_ptr<Storage *[]> segments;
+    };
+
+    std::atomic<size_t> count{0};
+    std::atomic<Directory *> directory{nullptr};
+    // 발행했던 segment 목록 전부 (마지막이 현재 것). segment 자체는 현재 목록 기준으로 해제한다
+    std::vector<std::unique_ptr<Directory>> directories;
+
+    T *slot(size_t i) const
+    {
+        Directory *dir = directory.load(std::memory_order_acquire);
+        return reinterpret_cast<T *>(&dir->segments[i >> SEGMENT_BITS][i & (SEGMENT_SIZE - 1)]);
+    }
+
+    Directory *grow(Directory *old)
+    {
+        const size_t capacity = old ? old->capacity * 2 : 8;
+        auto next = std::make_unique<Directory>();
+        next->capacity = capacity;
+        next->segments.reset(new Storage *[capacity]());
+        if (old)
+        {
+            for (size_t s = 0; s < old->capacity; ++s)
+                next->segments[s] = old->segments[s];
+        }
+        Directory *published = next.get();
+        directories.push_back(std::move(next));
+        directory.store(published, std::memory_order_release);
+        return published;
+    }
+};
+
+#endif
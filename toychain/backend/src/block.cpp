@@ -1,67 +1,145 @@
 #include "block.h"
-#include <sstream>
-#include <iomanip>
-#include <openssl/sha.h>
+#include "pow.h"
+#include <array>
+#include <charconv>
 #include <iostream>
+#include <string_view>
 
-Block::Block(int idx, const std::vector<UTXOTransaction> &txs, const std::string &prevHash)
-    : index(idx), transactions(txs), previousHash(prevHash), nonce(0), difficulty(0)
+Block::Block(int idx, const std::vector<UTXOTransaction> &txs, const Hash256 &prevHash)
+    : header{}, transactions(txs)
 {
-    timestamp = std::time(nullptr);
+    header.index = idx;
+    header.timestamp = std::time(nullptr);
+    header.previousHash = prevHash;
     hash = calculateHash();
 }
 Block::Block(int idx,
              long long ts,
              const std::vector<UTXOTransaction> &txs,
-             const std::string &prevHash,
+             const Hash256 &prevHash,
              int nonceVal,
              int diffVal)
-    : index(idx), timestamp(ts), transactions(txs), previousHash(prevHash), nonce(nonceVal), difficulty(diffVal)
+    : header{}, transactions(txs)
 {
+    header.index = idx;
+    header.timestamp = ts;
+    header.previousHash = prevHash;
+    header.nonce = nonceVal;
+    header.difficulty = diffVal;
     hash = calculateHash(); // 외부에서 받은 hash와 비교할 때 사용할 예정
 }
+Block::Block(const BlockHeader &hdr, std::vector<UTXOTransaction> txs, const Hash256 &storedHash)
+    : header(hdr), transactions(std::move(txs)), hash(storedHash)
+{
+}
+
+Hash256 Block::calculateHash() const
+{
+    return calculateHash(header.nonce);
+}
+
+Hash256 Block::calculateHash(int nonceVal) const
+{
+    return BlockHasher(*this).hashAt(nonceVal);
+}
 
-std::string Block::calculateHash() const
+bool Block::mineBlock(int diff, std::function<void(const Hash256 &, int)> onSample, unsigned threads,
+                      const ParallelMiner::StopFn &shouldStop)
 {
-    std::stringstream ss;
-    ss << index << timestamp << previousHash << nonce;
+    header.difficulty = diff;
+    ParallelMiner miner(threads);
 
-    for (const auto &tx : transactions)
+    while (true)
     {
-        ss << tx.toString();
+        BlockHasher hasher(*this);
+        auto result = miner.search(diff, header.nonce, [&hasher](int first, int count, Hash256 *out)
+                                   { hasher.hashRange(first, count, out); }, onSample, shouldStop);
+        if (result.stopped)
+            return false;
+        if (result.found)
+        {
+            header.nonce = result.nonce;
+            hash = result.hash;
+            break;
+        }
+        // nonce 공간을 다 쓰면 timestamp를 바꿔 처음부터 다시 탐색
+        header.timestamp++;
+        header.nonce = 0;
     }
 
-    std::string data = ss.str();
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    SHA256((unsigned char *)data.c_str(), data.size(), hash);
+    std::cout << "Block mined: " << hash.toHex() << std::endl;
+
+    if (onSample)
+        onSample(hash, header.nonce);
+    return true;
+}
+
+BlockHasher::BlockHasher(const Block &block)
+{
+    std::string prefix = std::to_string(block.getIndex()) + std::to_string(block.getTimestamp()) + block.getPreviousHash().toHex();
+    prefixState.update(prefix);
 
-    std::stringstream hashStr;
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++)
+    for (const auto &tx : block.getTransactions())
     {
-        hashStr << std::hex << std::setw(2) << std::setfill('0') << (int)hash[i];
+        suffix += tx.toString();
     }
-
-    return hashStr.str();
 }
 
-void Block::mineBlock(int diff, std::function<void(const std::string &, int)> onSample)
+Hash256 BlockHasher::hashAt(int nonce) const
 {
-    difficulty = diff;
-    std::string target(diff, '0');
+    char digits[16];
+    auto res = std::to_chars(digits, digits + sizeof(digits), nonce);
+
+    Hash256 out;
+    Sha256 ctx = prefixState;
+    ctx.update(digits, res.ptr - digits);
+    ctx.update(suffix);
+    ctx.finish(out.data());
+    return out;
+}
 
-    while (hash.substr(0, diff) != target)
+void BlockHasher::hashRange(int first, int count, Hash256 *out) const
+{
+    if (Sha256::laneCount() == 1)
     {
-        nonce++;
-        hash = calculateHash();
+        // 단일 버퍼 backend(scalar / SHA-NI)는 묶어도 이득이 없다
+        for (int i = 0; i < count; ++i)
+            out[i] = hashAt(first + i);
+        return;
+    }
 
-        if (onSample && nonce % 5000 == 0)
-        {
-            onSample(hash, nonce);
-        }
+    // lane마다 nonce 자릿수만 따로 두고, 직렬화된 트랜잭션(suffix)은 모든 lane이 그 자리에서 함께 읽는다
+    thread_local std::vector<std::array<char, 16>> digits;
+    thread_local std::vector<std::string_view> heads;
+    digits.resize(count);
+    heads.resize(count);
+
+    for (int i = 0; i < count; ++i)
+    {
+        auto res = std::to_chars(digits[i].data(), digits[i].data() + digits[i].size(), first + i);
+        heads[i] = std::string_view(digits[i].data(), res.ptr - digits[i].data());
     }
+    prefixState.finishMany(heads.data(), suffix, count, out);
+}
 
-    std::cout << "Block mined: " << hash << std::endl;
+void BlockHasher::hashBlocks(const Block *const *blocks, size_t count, Hash256 *out)
+{
+    std::vector<Sha256> bases;
+    std::vector<std::string> nonces;
+    std::vector<std::string> suffixes;
+    bases.reserve(count);
+    nonces.reserve(count);
+    suffixes.reserve(count);
 
-    if (onSample)
-        onSample(hash, nonce);
+    for (size_t i = 0; i < count; ++i)
+    {
+        BlockHasher hasher(*blocks[i]);
+        bases.push_back(hasher.prefixState);
+        nonces.push_back(std::to_string(blocks[i]->getNonce()));
+        suffixes.push_back(std::move(hasher.suffix));
+    }
+
+    std::vector<std::string_view> heads(nonces.begin(), nonces.end());
+    std::vector<std::string_view> tails(suffixes.begin(), suffixes.end());
+    Sha256::finishMany(bases.data(), heads.data(), tails.data(), count, out);
 }
@@ -2,40 +2,77 @@
 #define BLOCK_H
 
 #include "utxo.h"
+#include "crypto.h"
+#include "pow.h"
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <ctime>
 #include <functional>
 
+// 고정 크기 바이너리 블록 헤더 (패딩 없음)
+struct BlockHeader
+{
+    Hash256 previousHash;
+    int64_t timestamp;
+    int32_t index;
+    int32_t nonce;
+    int32_t difficulty;
+    uint32_t reserved;
+};
+static_assert(sizeof(BlockHeader) == 56, "BlockHeader must stay packed");
+
 class Block
 {
 private:
-    int index;
-    long long timestamp;
+    BlockHeader header;
     std::vector<UTXOTransaction> transactions;
-    std::string previousHash;
-    std::string hash;
-    int nonce;
-    int difficulty;
+    Hash256 hash;
 
 public:
-    Block(int idx, const std::vector<UTXOTransaction> &txs, const std::string &prevHash);
-    Block(int idx, long long ts, const std::vector<UTXOTransaction> &txs, const std::string &prevHash, int nonceVal, int diffVal);
-    void setTimestamp(long long time) { timestamp = time; }
-    void setHash(const std::string &newHash) { hash = newHash; }
-    void setNonce(int n) { nonce = n; }
-    void setDifficulty(int diff) { difficulty = diff; }
-    void mineBlock(int difficulty, std::function<void(const std::string &, int)> onSample = nullptr);
-    std::string calculateHash() const;
-
-    int getIndex() const { return index; }
-    long long getTimestamp() const { return timestamp; }
+    Block(int idx, const std::vector<UTXOTransaction> &txs, const Hash256 &prevHash);
+    Block(int idx, long long ts, const std::vector<UTXOTransaction> &txs, const Hash256 &prevHash, int nonceVal, int diffVal);
+    // 저장소에서 읽은 블록용: 저장된 해시를 그대로 쓰고 다시 계산하지 않는다
+    Block(const BlockHeader &hdr, std::vector<UTXOTransaction> txs, const Hash256 &storedHash);
+    void setTimestamp(long long time) { header.timestamp = time; }
+    void setHash(const Hash256 &newHash) { hash = newHash; }
+    void setNonce(int n) { header.nonce = n; }
+    void setDifficulty(int diff) { header.difficulty = diff; }
+    // shouldStop으로 멈추면 nonce/해시를 그대로 두고 false
+    bool mineBlock(int difficulty, std::function<void(const Hash256 &, int)> onSample = nullptr, unsigned threads = 1,
+                   const ParallelMiner::StopFn &shouldStop = nullptr);
+    Hash256 calculateHash() const;
+    Hash256 calculateHash(int nonceVal) const; // nonce만 바꿔 계산 (채굴 worker용)
+
+    const BlockHeader &getHeader() const { return header; }
+    int getIndex() const { return header.index; }
+    long long getTimestamp() const { return header.timestamp; }
     const std::vector<UTXOTransaction> &getTransactions() const { return transactions; }
-    std::string getPreviousHash() const { return previousHash; }
-    std::string getHash() const { return hash; }
-    int getNonce() const { return nonce; }
-    int getDifficulty() const { return difficulty; }
+    const Hash256 &getPreviousHash() const { return header.previousHash; }
+    const Hash256 &getHash() const { return hash; }
+    int getNonce() const { return header.nonce; }
+    int getDifficulty() const { return header.difficulty; }
+
+};
+
+// 블록 해시 입력은 index|timestamp|previousHash|nonce|tx... 순서로 직렬화된다.
+// 채굴 중에는 nonce만 바뀌므로 nonce 앞부분의 SHA-256 midstate와 nonce 뒷부분(트랜잭션 직렬화)을
+// 한 번만 만들어 두고, 시도마다 nonce 이후 블록만 다시 압축한다.
+class BlockHasher
+{
+private:
+    Sha256 prefixState;
+    std::string suffix;
+
+public:
+    explicit BlockHasher(const Block &block);
+
+    Hash256 hashAt(int nonce) const;
+    // 연속된 nonce first .. first+count-1 을 SIMD lane에 나눠 한 번에 해시
+    void hashRange(int first, int count, Hash256 *out) const;
 
+    // 서로 다른 블록들의 저장된 nonce 기준 해시를 한 번에 계산 (체인 검증용)
+    static void hashBlocks(const Block *const *blocks, size_t count, Hash256 *out);
 };
 
 #endif
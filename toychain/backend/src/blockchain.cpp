@@ -3,20 +3,26 @@
 #include <unordered_map>
 #include <sstream>
 #include <fstream>
+#include <algorithm>
+#include <string_view>
 
-Blockchain::Blockchain() : database(nullptr)
+Blockchain::Blockchain()
+    : pendingPool(std::make_shared<ChainSnapshot::TxPool>()), utxoSet(std::make_shared<UTXOSet>()),
+      persistence(nullptr), snapshotter(nullptr), snapshotEvery(0)
 {
     chain.push_back(createGenesisBlock());
     difficulty = 2;
     miningReward = 10.0;
     blockTimeTarget = 10;
     difficultyAdjustmentInterval = 5;
+    miningThreads = 0;
+    publish();
 }
 
 Block Blockchain::createGenesisBlock()
 {
     std::vector<UTXOTransaction> genesisTransactions;
-    Block genesis(0, genesisTransactions, "0");
+    Block genesis(0, genesisTransactions, Hash256()); // 부모 없음 ("0")
     genesis.setTimestamp(0);                  // timestamp 고정
     genesis.setHash(genesis.calculateHash()); // timestamp 바뀌었으니 hash도 다시 계산
     return genesis;
@@ -24,27 +30,133 @@ Block Blockchain::createGenesisBlock()
 
 Block Blockchain::getLatestBlock() const
 {
-    return chain.back();
+    return chain[snapshot()->height - 1];
 }
 
-bool Blockchain::isUTXOInPending(const std::string &txId, int index) const
+Hash256 Blockchain::tipHash() const
 {
-    if (index < 0)
-        return false;
-    for (const auto &tx : pendingTransactions)
+    const size_t last = chain.size() - 1;
+    return chain.isMapped(last) ? chain.view(last).getHash() : chain[last].getHash();
+}
+
+void Blockchain::publish()
+{
+    auto next = std::make_shared<ChainSnapshot>();
+    next->height = chain.size();
+    next->tipHash = tipHash();
+    next->difficulty = difficulty;
+    next->utxo = utxoSet;
+    next->pendingPool = pendingPool;
+    next->pendingCount = pendingPool->size();
+    if (!published || published->tipHash != next->tipHash)
+        tipChanges.fetch_add(1, std::memory_order_release);
+    std::atomic_store(&published, std::shared_ptr<const ChainSnapshot>(std::move(next)));
+}
+
+std::shared_ptr<UTXOSet> Blockchain::beginUTXOUpdate()
+{
+    if (utxoSpare && utxoSpare.use_count() == 1)
     {
-        for (const auto &input : tx.getInputs())
+        // 이전 버전을 보던 스냅샷이 모두 사라졌다. 마지막 적용에서 바뀐 outpoint만 현재 값으로 맞춰 다시 쓴다
+        std::atomic_thread_fence(std::memory_order_acquire);
+        for (const auto &outPoint : utxoSpareLag)
         {
-            if (input.txId == txId && input.outputIndex == index)
+            if (utxoSet->hasUTXO(outPoint))
+            {
+                utxoSpare->addUTXO(outPoint, utxoSet->getUTXO(outPoint));
+            }
+            else
             {
-                return true;
+                utxoSpare->removeUTXO(outPoint);
             }
         }
+        utxoSpareLag.clear();
+        return std::move(utxoSpare);
+    }
+    utxoSpare.reset();
+    utxoSpareLag.clear();
+    return std::make_shared<UTXOSet>(*utxoSet);
+}
+
+void Blockchain::commitUTXOUpdate(std::shared_ptr<UTXOSet> next, const UTXOSet::UndoLog &undo)
+{
+    utxoSpare = std::move(utxoSet);
+    utxoSet = std::move(next);
+    utxoSpareLag.clear();
+    utxoSpareLag.reserve(undo.size());
+    for (const auto &entry : undo)
+    {
+        utxoSpareLag.push_back(entry.outPoint);
+    }
+}
+
+bool Blockchain::isUTXOInPending(const OutPoint &outPoint) const
+{
+    return pendingSpent.count(outPoint) != 0;
+}
+
+void Blockchain::trackPendingInputs(const UTXOTransaction &tx)
+{
+    for (const auto &input : tx.getInputs())
+    {
+        if (input.outputIndex >= 0)
+        {
+            pendingSpent.insert(input.outPoint());
+        }
+    }
+}
+
+void Blockchain::untrackPendingInputs(const UTXOTransaction &tx)
+{
+    for (const auto &input : tx.getInputs())
+    {
+        if (input.outputIndex >= 0)
+        {
+            pendingSpent.erase(input.outPoint());
+        }
     }
-    return false;
 }
 
-bool Blockchain::addTransaction(const std::string &from, const std::string &to, double amount, std::string &error)
+void Blockchain::removeMinedPending(const std::unordered_set<Hash256, Hash256Hasher> &included)
+{
+    std::vector<Hash256> minedIds;
+    const size_t count = pendingPool->size();
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (included.count((*pendingPool)[i].getId()) != 0)
+        {
+            minedIds.push_back((*pendingPool)[i].getId());
+        }
+    }
+    if (minedIds.empty())
+    {
+        return;
+    }
+
+    // 예전 목록은 그것을 보는 스냅샷이 있을 수 있으므로 남은 트랜잭션으로 새 목록을 만든다
+    auto stillPending = std::make_shared<ChainSnapshot::TxPool>();
+    for (size_t i = 0; i < count; ++i)
+    {
+        const UTXOTransaction &tx = (*pendingPool)[i];
+        if (included.count(tx.getId()) == 0)
+        {
+            stillPending->push_back(tx);
+        }
+        else
+        {
+            untrackPendingInputs(tx);
+        }
+    }
+    pendingPool = std::move(stillPending);
+
+    if (persistence)
+    {
+        lastPersistSeq = persistence->submitMempool({}, std::move(minedIds));
+    }
+}
+
+bool Blockchain::addTransaction(const std::string &from, const std::string &to, double amount, std::string &error,
+                                std::optional<UTXOTransaction> *created)
 {
     if (amount <= 0)
     {
@@ -52,26 +164,19 @@ bool Blockchain::addTransaction(const std::string &from, const std::string &to,
         return false;
     }
 
-    auto available = utxoSet.getUTXOsForAddress(from);
+    std::lock_guard<std::mutex> lock(writeMutex);
+    auto available = utxoSet->getUTXOsForAddress(from);
     std::vector<TxInput> inputs;
     double collected = 0.0;
 
-    for (const auto &[key, output] : available)
+    for (const auto &[outPoint, output] : available)
     {
-        auto delimiter = key.find(':');
-        if (delimiter == std::string::npos)
-        {
-            continue;
-        }
-        std::string txId = key.substr(0, delimiter);
-        int outIndex = std::stoi(key.substr(delimiter + 1));
-
-        if (isUTXOInPending(txId, outIndex))
+        if (isUTXOInPending(outPoint))
         {
             continue; // 이미 사용 중인 UTXO는 건너뛴다
         }
 
-        inputs.emplace_back(txId, outIndex, from);
+        inputs.emplace_back(outPoint.txId, static_cast<int>(outPoint.index), from);
         collected += output.amount;
 
         if (collected >= amount)
@@ -96,15 +201,21 @@ bool Blockchain::addTransaction(const std::string &from, const std::string &to,
         outputs.emplace_back(change, from);
     }
 
-    pendingTransactions.emplace_back(inputs, outputs);
-    if (database)
+    const UTXOTransaction &tx = pendingPool->emplace_back(inputs, outputs);
+    trackPendingInputs(tx);
+    if (persistence)
+    {
+        lastPersistSeq = persistence->submitMempool({tx}, {});
+    }
+    if (created)
     {
-        database->upsertMempool(pendingTransactions);
+        *created = tx;
     }
+    publish();
     return true;
 }
 
-void Blockchain::applyTransactionToUTXOSet(const UTXOTransaction &tx)
+void Blockchain::applyTransactionToUTXOSet(UTXOSet &set, const UTXOTransaction &tx, UTXOSet::UndoLog *undo)
 {
     // Spend inputs
     for (const auto &input : tx.getInputs())
@@ -113,82 +224,167 @@ void Blockchain::applyTransactionToUTXOSet(const UTXOTransaction &tx)
         {
             continue; // coinbase dummy input
         }
-        utxoSet.removeUTXO(input.txId, input.outputIndex);
+        set.removeUTXO(input.outPoint(), undo);
     }
 
     // Add outputs
     const auto &outputs = tx.getOutputs();
     for (size_t i = 0; i < outputs.size(); ++i)
     {
-        utxoSet.addUTXO(tx.getId(), static_cast<int>(i), outputs[i]);
+        set.addUTXO(OutPoint(tx.getId(), static_cast<uint32_t>(i)), outputs[i], undo);
     }
 }
 
-void Blockchain::minePendingTransactions(const std::string &minerAddress, std::function<void(const std::string &, int)> onSample)
+const Block *Blockchain::minePendingTransactions(const std::string &minerAddress, std::function<void(const Hash256 &, int)> onSample,
+                                                 const std::atomic<bool> *cancel)
 {
-    // 난이도 자동 조정
-    if (chain.size() % difficultyAdjustmentInterval == 0 && chain.size() > 0)
+    std::unique_lock<std::mutex> lock(writeMutex);
+    while (true)
     {
-        adjustDifficulty();
-    }
-
-    // 채굴 보상 트랜잭션 (입력 없음, 보상 출력만) - dummy input으로 고유 txid 확보
-    std::vector<TxInput> coinbaseInputs;
-    coinbaseInputs.emplace_back(getLatestBlock().getHash(), -1, minerAddress); // unique dummy input
-    std::vector<TxOutput> coinbaseOutputs = {TxOutput(miningReward, minerAddress)};
-    UTXOTransaction coinbaseTx(coinbaseInputs, coinbaseOutputs);
+        // 난이도 자동 조정 (같은 높이에서 다시 채굴할 때는 한 번만)
+        const size_t height = chain.size();
+        if (height % difficultyAdjustmentInterval == 0 && height > 0 && difficultyCheckedAt != height)
+        {
+            difficultyCheckedAt = height;
+            adjustDifficultyLocked();
+            publish();
+        }
 
-    std::vector<UTXOTransaction> transactions;
-    transactions.push_back(coinbaseTx);
-    transactions.insert(transactions.end(), pendingTransactions.begin(), pendingTransactions.end());
+        // 채굴 보상 트랜잭션 (입력 없음, 보상 출력만) - dummy input으로 고유 txid 확보
+        const Hash256 tip = tipHash();
+        std::vector<TxInput> coinbaseInputs;
+        coinbaseInputs.emplace_back(tip, -1, minerAddress); // unique dummy input
+        std::vector<TxOutput> coinbaseOutputs = {TxOutput(miningReward, minerAddress)};
+        UTXOTransaction coinbaseTx(coinbaseInputs, coinbaseOutputs);
+
+        std::vector<UTXOTransaction> transactions;
+        transactions.reserve(1 + pendingPool->size());
+        transactions.push_back(coinbaseTx);
+        for (size_t i = 0; i < pendingPool->size(); ++i)
+        {
+            transactions.push_back((*pendingPool)[i]);
+        }
+        const int blockDifficulty = difficulty;
+        const uint64_t tipVersion = tipChanges.load(std::memory_order_relaxed);
+
+        // 작업증명은 잠금 없이 한다. 그동안 조회, 트랜잭션 추가, 블록 수신은 그대로 진행된다
+        lock.unlock();
+        Block block(static_cast<int>(height), transactions, tip);
+        const bool mined = block.mineBlock(blockDifficulty, onSample, miningThreads, [this, cancel, tipVersion]()
+                                           { return (cancel && cancel->load(std::memory_order_relaxed)) ||
+                                                    tipChanges.load(std::memory_order_relaxed) != tipVersion; });
+        if (!mined && cancel && cancel->load())
+        {
+            std::cout << "⚠️ Mining cancelled at height " << height << "\n";
+            return nullptr;
+        }
+        lock.lock();
 
-    Block block(chain.size(), transactions, getLatestBlock().getHash());
-    block.mineBlock(difficulty, onSample);
+        if (!mined || chain.size() != height || tipHash() != tip)
+        {
+            std::cout << "⚠️ Chain advanced to height " << chain.size() << " while mining, mining again on the new tip\n";
+            continue;
+        }
 
-    // 블록 확정 후 UTXO 반영
-    for (const auto &tx : transactions)
-    {
-        applyTransactionToUTXOSet(tx);
-    }
+        // 블록 확정 후 UTXO 반영
+        auto next = beginUTXOUpdate();
+        UTXOSet::UndoLog undo;
+        for (const auto &tx : transactions)
+        {
+            applyTransactionToUTXOSet(*next, tx, &undo);
+        }
+        commitUTXOUpdate(std::move(next), undo);
+        chain.push_back(block);
 
-    chain.push_back(block);
-    pendingTransactions.clear();
+        if (persistence)
+        {
+            lastPersistSeq = persistence->submitBlock(&chain.back());
+        }
+        // 블록에 들어간 pending 트랜잭션(coinbase 제외)을 mempool에서 지운다. 채굴 중에 들어온 것은 남는다
+        std::unordered_set<Hash256, Hash256Hasher> included;
+        for (size_t i = 1; i < transactions.size(); ++i)
+        {
+            included.insert(transactions[i].getId());
+        }
+        removeMinedPending(included);
+        maybeSnapshot();
+        publish();
 
-    if (database)
-    {
-        database->insertBlock(block, transactions);
-        database->upsertMempool(pendingTransactions);
+        std::cout << "Block successfully mined!\n";
+        return &chain.back();
     }
-
-    std::cout << "Block successfully mined!\n";
 }
 
 bool Blockchain::isChainValid() const
 {
-    for (std::size_t i = 1; i < chain.size(); ++i)
-    {
-        const Block &current = chain[i];
-        const Block &previous = chain[i - 1];
+    // 블록 해시 재계산은 CHUNK개씩 묶어 multi-buffer SHA-256으로 처리한다
+    const std::size_t CHUNK = 1024;
+    const std::size_t height = snapshot()->height;
+    std::vector<const Block *> batch;
+    std::vector<Hash256> hashes;
 
-        if (current.getHash() != current.calculateHash())
+    for (std::size_t start = 1; start < height; start += CHUNK)
+    {
+        std::size_t end = std::min(height, start + CHUNK);
+        batch.clear();
+        for (std::size_t i = start; i < end; ++i)
         {
-            return false;
+            batch.push_back(&chain[i]);
         }
+        hashes.resize(batch.size());
+        BlockHasher::hashBlocks(batch.data(), batch.size(), hashes.data());
 
-        if (current.getPreviousHash() != previous.getHash())
+        for (std::size_t i = start; i < end; ++i)
         {
-            return false;
+            const Block &current = chain[i];
+            const Block &previous = chain[i - 1];
+
+            if (current.getHash() != hashes[i - start])
+            {
+                return false;
+            }
+
+            if (current.getPreviousHash() != previous.getHash())
+            {
+                return false;
+            }
         }
     }
     return true;
 }
 
+void Blockchain::setDifficulty(int diff)
+{
+    std::lock_guard<std::mutex> lock(writeMutex);
+    setDifficultyLocked(diff);
+    publish();
+}
+
+void Blockchain::setDifficultyLocked(int diff)
+{
+    difficulty = diff;
+    if (persistence)
+    {
+        lastPersistSeq = persistence->submitDifficulty(difficulty);
+    }
+}
+
 void Blockchain::adjustDifficulty()
+{
+    std::lock_guard<std::mutex> lock(writeMutex);
+    adjustDifficultyLocked();
+    publish();
+}
+
+void Blockchain::adjustDifficultyLocked()
 {
     int newDifficulty = calculateNewDifficulty();
 
     std::cout << "Difficulty adjustment: " << difficulty << " -> " << newDifficulty << "\n";
-    difficulty = newDifficulty;
+    if (newDifficulty != difficulty)
+    {
+        setDifficultyLocked(newDifficulty);
+    }
 }
 
 int Blockchain::calculateNewDifficulty() const
@@ -219,33 +415,17 @@ int Blockchain::calculateNewDifficulty() const
 
 std::unordered_map<std::string, double> Blockchain::getBalances() const
 {
-    std::unordered_map<std::string, double> balances;
-    auto all = utxoSet.getAllUTXOs();
-    for (const auto &[key, output] : all)
-    {
-        balances[output.address] += output.amount;
-    }
-    return balances;
+    return snapshot()->utxo->getBalances();
 }
 
-std::vector<std::tuple<std::string, int, TxOutput>> Blockchain::getUTXOs() const
+std::vector<std::pair<OutPoint, TxOutput>> Blockchain::getUTXOs() const
 {
-    std::vector<std::tuple<std::string, int, TxOutput>> list;
-    auto all = utxoSet.getAllUTXOs();
-    for (const auto &[key, output] : all)
-    {
-        auto pos = key.find(':');
-        if (pos == std::string::npos)
-            continue;
-        std::string txId = key.substr(0, pos);
-        int outIdx = std::stoi(key.substr(pos + 1));
-        list.emplace_back(txId, outIdx, output);
-    }
-    return list;
+    return snapshot()->utxo->getAllUTXOs();
 }
 
 bool Blockchain::saveToFile(const std::string &path) const
 {
+    std::lock_guard<std::mutex> lock(writeMutex);
     std::ofstream out(path);
     if (!out.is_open())
     {
@@ -259,17 +439,17 @@ bool Blockchain::saveToFile(const std::string &path) const
     for (const auto &block : chain)
     {
         out << "BLOCK " << block.getIndex() << " " << block.getTimestamp() << " " << block.getNonce() << " " << block.getDifficulty() << "\n";
-        out << "PREV " << block.getPreviousHash() << "\n";
-        out << "HASH " << block.getHash() << "\n";
+        out << "PREV " << block.getPreviousHash().toHex() << "\n";
+        out << "HASH " << block.getHash().toHex() << "\n";
 
         const auto &txs = block.getTransactions();
         out << "TXCOUNT " << txs.size() << "\n";
         for (const auto &tx : txs)
         {
-            out << "TX " << tx.getId() << " " << tx.getInputs().size() << " " << tx.getOutputs().size() << "\n";
+            out << "TX " << tx.getId().toHex() << " " << tx.getInputs().size() << " " << tx.getOutputs().size() << "\n";
             for (const auto &in : tx.getInputs())
             {
-                out << "IN " << in.txId << " " << in.outputIndex << " " << in.signature << "\n";
+                out << "IN " << in.txId.toHex() << " " << in.outputIndex << " " << in.signature << "\n";
             }
             for (const auto &outTx : tx.getOutputs())
             {
@@ -281,162 +461,423 @@ bool Blockchain::saveToFile(const std::string &path) const
     return true;
 }
 
-void Blockchain::addExternalPending(const UTXOTransaction &tx)
+bool Blockchain::addExternalPending(const UTXOTransaction &tx)
 {
-    pendingTransactions.push_back(tx);
-    if (database)
+    std::lock_guard<std::mutex> lock(writeMutex);
+    for (size_t i = 0; i < pendingPool->size(); ++i)
+    {
+        if ((*pendingPool)[i].getId() == tx.getId())
+        {
+            return false;
+        }
+    }
+
+    pendingPool->push_back(tx);
+    trackPendingInputs(tx);
+    if (persistence)
     {
-        database->upsertMempool(pendingTransactions);
+        lastPersistSeq = persistence->submitMempool({tx}, {});
     }
+    publish();
+    return true;
 }
 
 bool Blockchain::loadFromFile(const std::string &path)
 {
+    std::lock_guard<std::mutex> lock(writeMutex);
     std::ifstream in(path);
     if (!in.is_open())
     {
         return false;
     }
 
-    std::vector<Block> loadedChain;
+    // 트랜잭션 id는 파일을 다 읽은 뒤 multi-buffer SHA-256으로 한 번에 다시 계산한다
+    struct RawTx
+    {
+        std::vector<TxInput> inputs;
+        std::vector<TxOutput> outputs;
+    };
+    struct RawBlock
+    {
+        int idx;
+        long long ts;
+        int nonce;
+        int diff;
+        Hash256 prevHash;
+        Hash256 hash;
+        std::vector<RawTx> txs;
+    };
+
+    std::vector<RawBlock> rawBlocks;
     int loadedDifficulty = difficulty;
     std::string line;
     int declaredBlocks = 0;
 
-    while (std::getline(in, line))
+    try
     {
-        if (line.empty())
-        {
-            continue;
-        }
-        std::istringstream iss(line);
-        std::string tag;
-        iss >> tag;
-
-        if (tag == "DIFFICULTY")
-        {
-            iss >> loadedDifficulty;
-        }
-        else if (tag == "BLOCKS")
-        {
-            iss >> declaredBlocks;
-        }
-        else if (tag == "BLOCK")
+        while (std::getline(in, line))
         {
-            int idx;
-            long long ts;
-            int nonce;
-            int diff;
-            iss >> idx >> ts >> nonce >> diff;
-
-            std::string prevHashLine;
-            std::string hashLine;
-            std::string txCountLine;
-
-            if (!std::getline(in, prevHashLine) || !std::getline(in, hashLine) || !std::getline(in, txCountLine))
+            if (line.empty())
             {
-                std::cerr << "Corrupted state file while reading block headers.\n";
-                return false;
+                continue;
             }
+            std::istringstream iss(line);
+            std::string tag;
+            iss >> tag;
 
-            std::istringstream prevIss(prevHashLine);
-            std::istringstream hashIss(hashLine);
-            std::istringstream txCountIss(txCountLine);
-            std::string prevTag, hashTag, txCountTag;
-            std::string prevHash;
-            std::string hash;
-            size_t txCount = 0;
-            prevIss >> prevTag >> prevHash;
-            hashIss >> hashTag >> hash;
-            txCountIss >> txCountTag >> txCount;
-
-            std::vector<UTXOTransaction> txs;
-            for (size_t t = 0; t < txCount; ++t)
+            if (tag == "DIFFICULTY")
             {
-                std::string txLine;
-                if (!std::getline(in, txLine))
+                iss >> loadedDifficulty;
+            }
+            else if (tag == "BLOCKS")
+            {
+                iss >> declaredBlocks;
+            }
+            else if (tag == "BLOCK")
+            {
+                int idx;
+                long long ts;
+                int nonce;
+                int diff;
+                iss >> idx >> ts >> nonce >> diff;
+
+                std::string prevHashLine;
+                std::string hashLine;
+                std::string txCountLine;
+
+                if (!std::getline(in, prevHashLine) || !std::getline(in, hashLine) || !std::getline(in, txCountLine))
                 {
-                    std::cerr << "Corrupted state file while reading transaction header.\n";
+                    std::cerr << "Corrupted state file while reading block headers.\n";
                     return false;
                 }
-                std::istringstream txIss(txLine);
-                std::string txTag, txId;
-                size_t inCount = 0, outCount = 0;
-                txIss >> txTag >> txId >> inCount >> outCount;
 
-                std::vector<TxInput> inputs;
-                for (size_t i = 0; i < inCount; ++i)
+                std::istringstream prevIss(prevHashLine);
+                std::istringstream hashIss(hashLine);
+                std::istringstream txCountIss(txCountLine);
+                std::string prevTag, hashTag, txCountTag;
+                std::string prevHash;
+                std::string hash;
+                size_t txCount = 0;
+                prevIss >> prevTag >> prevHash;
+                hashIss >> hashTag >> hash;
+                txCountIss >> txCountTag >> txCount;
+
+                RawBlock raw{idx, ts, nonce, diff, Hash256::fromHex(prevHash), Hash256::fromHex(hash), {}};
+                for (size_t t = 0; t < txCount; ++t)
                 {
-                    std::string inLine;
-                    std::getline(in, inLine);
-                    std::istringstream inIss(inLine);
-                    std::string inTag, inTxId, signature;
-                    int outIndex;
-                    inIss >> inTag >> inTxId >> outIndex >> signature;
-                    inputs.emplace_back(inTxId, outIndex, signature);
+                    std::string txLine;
+                    if (!std::getline(in, txLine))
+                    {
+                        std::cerr << "Corrupted state file while reading transaction header.\n";
+                        return false;
+                    }
+                    std::istringstream txIss(txLine);
+                    std::string txTag, txId;
+                    size_t inCount = 0, outCount = 0;
+                    txIss >> txTag >> txId >> inCount >> outCount;
+
+                    std::vector<TxInput> inputs;
+                    for (size_t i = 0; i < inCount; ++i)
+                    {
+                        std::string inLine;
+                        std::getline(in, inLine);
+                        std::istringstream inIss(inLine);
+                        std::string inTag, inTxId, signature;
+                        int outIndex;
+                        inIss >> inTag >> inTxId >> outIndex >> signature;
+                        inputs.emplace_back(Hash256::fromHex(inTxId), outIndex, signature);
+                    }
+
+                    std::vector<TxOutput> outputs;
+                    for (size_t o = 0; o < outCount; ++o)
+                    {
+                        std::string outLine;
+                        std::getline(in, outLine);
+                        std::istringstream outIss(outLine);
+                        std::string outTag, address;
+                        double amount;
+                        outIss >> outTag >> amount >> address;
+                        outputs.emplace_back(amount, address);
+                    }
+
+                    raw.txs.push_back({std::move(inputs), std::move(outputs)});
                 }
+                rawBlocks.push_back(std::move(raw));
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Corrupted state file: " << e.what() << "\n";
+        return false;
+    }
 
-                std::vector<TxOutput> outputs;
-                for (size_t o = 0; o < outCount; ++o)
-                {
-                    std::string outLine;
-                    std::getline(in, outLine);
-                    std::istringstream outIss(outLine);
-                    std::string outTag, address;
-                    double amount;
-                    outIss >> outTag >> amount >> address;
-                    outputs.emplace_back(amount, address);
-                }
+    if (declaredBlocks != 0 && declaredBlocks != static_cast<int>(rawBlocks.size()))
+    {
+        std::cerr << "State file block count mismatch.\n";
+        return false;
+    }
 
-                UTXOTransaction tx(inputs, outputs);
-                txs.push_back(tx);
-            }
+    std::vector<std::string> preimages;
+    for (const auto &raw : rawBlocks)
+    {
+        for (const auto &tx : raw.txs)
+        {
+            preimages.push_back(UTXOTransaction::serialize(tx.inputs, tx.outputs));
+        }
+    }
+    std::vector<std::string_view> views(preimages.begin(), preimages.end());
+    std::vector<Hash256> txIds(views.size());
+    Sha256::hashMany(views.data(), views.size(), txIds.data());
 
-            Block block(idx, txs, prevHash);
-            block.setTimestamp(ts);
-            block.setNonce(nonce);
-            block.setDifficulty(diff);
-            block.setHash(hash);
-            loadedChain.push_back(block);
+    std::vector<Block> loadedChain;
+    loadedChain.reserve(rawBlocks.size());
+    size_t nextTx = 0;
+    for (auto &raw : rawBlocks)
+    {
+        std::vector<UTXOTransaction> txs;
+        txs.reserve(raw.txs.size());
+        for (auto &tx : raw.txs)
+        {
+            txs.emplace_back(txIds[nextTx++], tx.inputs, tx.outputs);
         }
+
+        Block block(raw.idx, raw.ts, txs, raw.prevHash, raw.nonce, raw.diff);
+        block.setHash(raw.hash);
+        loadedChain.push_back(std::move(block));
     }
 
-    if (declaredBlocks != 0 && declaredBlocks != static_cast<int>(loadedChain.size()))
+    chain.assign(std::move(loadedChain));
+    pendingPool = std::make_shared<ChainSnapshot::TxPool>();
+    pendingSpent.clear();
+    rebuildUTXOFromChain();
+    difficulty = loadedDifficulty;
+    publish();
+    return true;
+}
+
+bool Blockchain::loadFromLog(BlockLog &log)
+{
+    std::lock_guard<std::mutex> lock(writeMutex);
+    MappedBlocks mapped;
+    int loadedDifficulty = difficulty;
+    if (!log.load(mapped, loadedDifficulty))
     {
-        std::cerr << "State file block count mismatch.\n";
         return false;
     }
+    if (mapped.offsets.empty())
+    {
+        return true; // 새 로그
+    }
 
-    chain = loadedChain;
-    pendingTransactions.clear();
-    utxoSet = UTXOSet();
-    for (const auto &block : chain)
+    chain.assign(std::move(mapped));
+    pendingPool = std::make_shared<ChainSnapshot::TxPool>();
+    pendingSpent.clear();
+    try
     {
-        for (const auto &tx : block.getTransactions())
+        if (!restoreUTXOSnapshot())
         {
-            applyTransactionToUTXOSet(tx);
+            rebuildUTXOFromChain();
         }
     }
+    catch (const std::exception &e)
+    {
+        std::cerr << "❌ Corrupted block log " << log.getPath() << ": " << e.what() << "\n";
+        chain.assign(std::vector<Block>{createGenesisBlock()});
+        rebuildUTXOFromChain();
+        publish();
+        return false;
+    }
     difficulty = loadedDifficulty;
+    publish();
     return true;
 }
 
-void Blockchain::rebuildUTXOFromChain()
+bool Blockchain::writeToLog(BlockLog &log) const
 {
-    utxoSet = UTXOSet();
-    for (const auto &block : chain)
+    std::lock_guard<std::mutex> lock(writeMutex);
+    // 블록마다 fsync하지 않고 끝에서 한 번만 내린다
+    unsigned syncEvery = log.getSyncEvery();
+    log.setSyncEvery(0);
+
+    bool ok = log.appendDifficulty(difficulty);
+    for (size_t i = 0; ok && i < chain.size(); ++i)
+    {
+        ok = log.appendBlock(chain[i]);
+    }
+    ok = ok && log.sync();
+
+    log.setSyncEvery(syncEvery);
+    return ok;
+}
+
+void Blockchain::backfillDatabase(Database &db) const
+{
+    std::lock_guard<std::mutex> lock(writeMutex);
+    long long stored = db.getBlockCount();
+    if (stored < 0 || static_cast<size_t>(stored) >= chain.size())
+    {
+        return;
+    }
+
+    db.beginBatch();
+    for (size_t i = static_cast<size_t>(stored); i < chain.size(); ++i)
+    {
+        // 로그 레코드에서 임시로 만들어 쓰고 버린다 (체인에 Block을 붙잡아 두지 않는다)
+        if (chain.isMapped(i))
+        {
+            chain.verify(i);
+            Block block = chain.view(i).toBlock();
+            db.insertBlock(block, block.getTransactions());
+        }
+        else
+        {
+            db.insertBlock(chain[i], chain[i].getTransactions());
+        }
+    }
+    if (db.commitBatch())
+    {
+        std::cout << "Database backfilled with " << (chain.size() - stored) << " blocks\n";
+    }
+    else
+    {
+        std::cerr << "❌ Database backfill failed\n";
+    }
+}
+
+std::vector<Hash256> Blockchain::restoreMempool(std::vector<UTXOTransaction> saved)
+{
+    std::lock_guard<std::mutex> lock(writeMutex);
+    std::vector<Hash256> dropped;
+    for (auto &tx : saved)
     {
-        for (const auto &tx : block.getTransactions())
+        bool valid = true;
+        for (const auto &in : tx.getInputs())
         {
-            applyTransactionToUTXOSet(tx);
+            if (in.outputIndex >= 0 && (!utxoSet->hasUTXO(in.outPoint()) || isUTXOInPending(in.outPoint())))
+            {
+                valid = false;
+                break;
+            }
         }
+        if (!valid)
+        {
+            dropped.push_back(tx.getId());
+            continue;
+        }
+        trackPendingInputs(pendingPool->emplace_back(std::move(tx)));
+    }
+    publish();
+    if (!pendingPool->empty() || !dropped.empty())
+    {
+        std::cout << "Restored " << pendingPool->size() << " pending transactions (" << dropped.size() << " no longer valid)\n";
     }
+    return dropped;
+}
+
+bool Blockchain::waitDurable()
+{
+    return !persistence || persistence->waitDurable(lastPersistSeq);
+}
+
+void Blockchain::replayUTXOFrom(size_t first)
+{
+    if (first == 0)
+    {
+        utxoSet = std::make_shared<UTXOSet>();
+        utxoSpare.reset();
+        utxoSpareLag.clear();
+    }
+    for (size_t i = first; i < chain.size(); ++i)
+    {
+        // 로그에서 온 블록은 Block을 만들지 않고 레코드를 그 자리에서 읽는다
+        if (chain.isMapped(i))
+        {
+            chain.verify(i);
+            applyBlockViewToUTXOSet(chain.view(i));
+            continue;
+        }
+        for (const auto &tx : chain[i].getTransactions())
+        {
+            applyTransactionToUTXOSet(*utxoSet, tx);
+        }
+    }
+}
+
+bool Blockchain::restoreUTXOSnapshot()
+{
+    if (!snapshotter)
+    {
+        return false;
+    }
+    UTXOSet loaded;
+    uint64_t height = 0;
+    Hash256 tip{};
+    if (!snapshotter->load(loaded, height, tip))
+    {
+        return false;
+    }
+
+    // 스냅샷은 로그의 앞부분(height개 블록)과 정확히 같은 체인이어야 쓸 수 있다
+    if (height == 0 || height > chain.size())
+    {
+        std::cerr << "⚠️ UTXO snapshot height " << height << " is beyond the chain, rebuilding\n";
+        return false;
+    }
+    const size_t last = static_cast<size_t>(height - 1);
+    const Hash256 chainHash = chain.isMapped(last) ? chain.view(last).getHash() : chain[last].getHash();
+    if (chainHash != tip)
+    {
+        std::cerr << "⚠️ UTXO snapshot tip does not match the chain, rebuilding\n";
+        return false;
+    }
+
+    utxoSet = std::make_shared<UTXOSet>(std::move(loaded));
+    utxoSpare.reset();
+    utxoSpareLag.clear();
+    replayUTXOFrom(static_cast<size_t>(height));
+    std::cout << "✅ UTXO snapshot at height " << height << " restored, replayed "
+              << (chain.size() - height) << " blocks\n";
+    return true;
+}
+
+void Blockchain::maybeSnapshot()
+{
+    if (!persistence || snapshotEvery == 0 || chain.size() % snapshotEvery != 0)
+    {
+        return;
+    }
+    // 방금 발행할 UTXO 버전은 더 바뀌지 않으므로 복사 없이 넘기고, 직렬화와 파일 쓰기는 백그라운드 스레드가 한다.
+    // 파이프라인을 거치므로 스냅샷은 그 높이까지의 블록 로그가 기록된 뒤에 쓰인다.
+    lastPersistSeq = persistence->submitSnapshot(utxoSet, chain.size(), tipHash());
+}
+
+void Blockchain::applyBlockViewToUTXOSet(const BlockView &view)
+{
+    view.forEachTransaction([&](const TxView &tx)
+                            {
+        tx.forEachInput([&](const unsigned char *txId, int outputIndex, std::string_view)
+                        {
+            if (outputIndex < 0)
+            {
+                return; // coinbase dummy input
+            }
+            Hash256 id;
+            std::memcpy(id.data(), txId, Sha256::DIGEST_SIZE);
+            utxoSet->removeUTXO(OutPoint(id, static_cast<uint32_t>(outputIndex))); });
+
+        const Hash256 id = tx.id();
+        uint32_t index = 0;
+        tx.forEachOutput([&](double amount, std::string_view address)
+                         { utxoSet->addUTXO(OutPoint(id, index++), TxOutput(amount, std::string(address))); }); });
 }
 
 bool Blockchain::acceptExternalBlock(const Block &block)
 {
+    std::lock_guard<std::mutex> lock(writeMutex);
+
     // 1) 이전 해시/높이 검증
-    const Block &latest = getLatestBlock();
+    const Block &latest = chain.back();
     if (block.getPreviousHash() != latest.getHash())
     {
         std::cerr << "❌ external block prev_hash mismatch\n";
@@ -448,9 +889,10 @@ bool Blockchain::acceptExternalBlock(const Block &block)
         return false;
     }
 
-    // 3) UTXO 시뮬레이션 (롤백 대비)
-    UTXOSet utxoCopy = utxoSet; // 얕은 복사로 unordered_map 전체 복제됨
-    auto applyOn = [&](UTXOSet &target, const UTXOTransaction &tx)
+    // 3) UTXO 적용: 쓰기용 사본에서 블록이 건드리는 outpoint만 바꾸고 journal에 남긴다. 실패하면 그대로 되돌린다.
+    auto next = beginUTXOUpdate();
+    UTXOSet::UndoLog undo;
+    auto applyTx = [&](const UTXOTransaction &tx)
     {
         // inputs spend
         for (const auto &in : tx.getInputs())
@@ -459,7 +901,7 @@ bool Blockchain::acceptExternalBlock(const Block &block)
             {
                 continue; // dummy input (e.g., coinbase) — skip spending
             }
-            if (!target.removeUTXO(in.txId, in.outputIndex))
+            if (!next->removeUTXO(in.outPoint(), &undo))
             {
                 return false; // 참조 UTXO 없음 → 불가
             }
@@ -468,49 +910,40 @@ bool Blockchain::acceptExternalBlock(const Block &block)
         const auto &outs = tx.getOutputs();
         for (size_t i = 0; i < outs.size(); ++i)
         {
-            target.addUTXO(tx.getId(), static_cast<int>(i), outs[i]);
+            next->addUTXO(OutPoint(tx.getId(), static_cast<uint32_t>(i)), outs[i], &undo);
         }
         return true;
     };
 
     for (const auto &tx : block.getTransactions())
     {
-        if (!applyOn(utxoCopy, tx))
+        if (!applyTx(tx))
         {
+            // 되돌린 사본은 현재 버전과 같으므로 다음 쓰기용으로 남겨 둔다
+            next->rollback(undo);
+            utxoSpare = std::move(next);
             std::cerr << "❌ external block tx invalid (utxo missing)\n";
             return false;
         }
     }
 
-    // 4) 모두 통과 → 실제 체인/UTXO 반영
+    // 4) 모두 통과 → 체인에 연결
+    commitUTXOUpdate(std::move(next), undo);
     chain.push_back(block);
-    // 전체 체인을 기준으로 UTXO 재구성해 일관성 보장
-    rebuildUTXOFromChain();
-
-    // 5) pending에서 중복 제거
-    std::vector<UTXOTransaction> stillPending;
-    for (const auto &pendingTx : pendingTransactions)
+    if (persistence)
     {
-        bool included = false;
-        for (const auto &tx : block.getTransactions())
-        {
-            if (pendingTx.getId() == tx.getId())
-            {
-                included = true;
-                break;
-            }
-        }
-        if (!included)
-            stillPending.push_back(pendingTx);
+        lastPersistSeq = persistence->submitBlock(&chain.back());
     }
-    pendingTransactions.swap(stillPending);
+    maybeSnapshot();
 
-    // DB에 연결되어 있으면 저장
-    if (database)
+    // 5) pending에서 중복 제거 (블록에 포함된 트랜잭션의 입력은 spent 인덱스에서도 뺀다)
+    std::unordered_set<Hash256, Hash256Hasher> included;
+    for (const auto &tx : block.getTransactions())
     {
-        database->insertBlock(block, block.getTransactions());
-        database->upsertMempool(pendingTransactions);
+        included.insert(tx.getId());
     }
+    removeMinedPending(included);
+    publish();
 
     return true;
 }
@@ -1,60 +1,153 @@
 #ifndef BLOCKCHAIN_H
 #define BLOCKCHAIN_H
 
+#include "append_vector.h"
 #include "block.h"
 #include "utxo.h"
 #include "db/Database.hpp"
+#include "storage.h"
+#include "snapshot.h"
+#include "persistence.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <vector>
 #include <unordered_map>
-#include <tuple>
+#include <unordered_set>
 
+// reader가 보는 체인 상태 한 벌. 발행된 뒤에는 바뀌지 않으므로 잠금 없이 읽는다.
+// 블록 본문은 Blockchain::getChain()에서 height 안쪽만 읽는다 (그 범위의 블록은 그대로 남아 있다).
+struct ChainSnapshot
+{
+    // mempool 트랜잭션 목록. writer는 뒤에 붙이기만 하고, 블록이 일부를 가져가면 새 목록을 만든다
+    using TxPool = AppendVector<UTXOTransaction>;
+
+    size_t height = 0; // 블록 수
+    Hash256 tipHash;
+    int difficulty = 0;
+    std::shared_ptr<const UTXOSet> utxo;
+    std::shared_ptr<const TxPool> pendingPool;
+    size_t pendingCount = 0; // pendingPool에서 이 스냅샷에 속하는 앞쪽 개수
+
+    const UTXOTransaction &pending(size_t i) const { return (*pendingPool)[i]; }
+};
+
+// 동시성: 상태를 바꾸는 호출은 writeMutex로 하나씩 처리하고, 끝날 때 새 ChainSnapshot을 원자적으로 발행한다.
+// 조회(snapshot(), getBalances, getUTXOs, getDifficulty, getLatestBlock)는 발행된 스냅샷만 보므로
+// 채굴이나 블록 수신을 기다리지 않고, writer도 reader를 기다리지 않는다.
+// 채굴의 작업증명은 잠금 밖에서 하며, 그 사이 체인 끝이 바뀌면 새 끝에서 다시 채굴한다.
 class Blockchain
 {
 private:
-    std::vector<Block> chain;
-    std::vector<UTXOTransaction> pendingTransactions;
-    UTXOSet utxoSet;
-    Database *database;
+    ChainStore chain;
+    std::shared_ptr<ChainSnapshot::TxPool> pendingPool;
+    // pending 트랜잭션들이 이미 입력으로 쓰고 있는 outpoint (mempool 이중 지불 검사용)
+    std::unordered_set<OutPoint, OutPointHasher> pendingSpent;
+    // 발행된 현재 UTXO 버전. 블록마다 쓰기용 사본에 적용한 뒤 통째로 바꾼다
+    std::shared_ptr<UTXOSet> utxoSet;
+    // 바로 이전 버전. 그것을 보던 reader가 모두 놓으면 utxoSpareLag만 다시 맞춰 다음 쓰기용으로 쓴다
+    std::shared_ptr<UTXOSet> utxoSpare;
+    std::vector<OutPoint> utxoSpareLag;
+    std::shared_ptr<const ChainSnapshot> published;
+    // 팁이 바뀐 횟수. 채굴 중인 스레드가 잠금 없이 보고 낡은 템플릿을 버린다
+    std::atomic<uint64_t> tipChanges{0};
+    mutable std::mutex writeMutex;
+    size_t difficultyCheckedAt = 0; // 난이도 조정을 마지막으로 확인한 높이
+    // 연결되어 있으면 확정된 블록/난이도 변경/mempool/스냅샷을 이벤트로 넘긴다 (쓰기는 파이프라인 스레드가 한다)
+    PersistencePipeline *persistence;
+    std::atomic<uint64_t> lastPersistSeq{0};
+    UTXOSnapshotter *snapshotter; // 시작할 때 UTXO 스냅샷을 읽는 곳
+    unsigned snapshotEvery;       // persistence가 있으면 이 블록 수마다 스냅샷 이벤트를 넣는다
     int difficulty;
     double miningReward;
 
     int blockTimeTarget;
     int difficultyAdjustmentInterval;
+    unsigned miningThreads; // 0 이면 하드웨어 스레드 수만큼 사용
 
 public:
     Blockchain();
-    void attachDatabase(Database *db) { database = db; }
+    void attachPersistence(PersistencePipeline *p) { persistence = p; }
+    // every가 0이면 스냅샷을 쓰지 않는다 (loadFromLog에서 읽기만 한다)
+    void attachSnapshotter(UTXOSnapshotter *s, unsigned every)
+    {
+        snapshotter = s;
+        snapshotEvery = every;
+    }
 
     Block createGenesisBlock();
+    // 지금 발행된 상태. 들고 있는 동안 그 버전의 UTXO/mempool이 유지된다
+    std::shared_ptr<const ChainSnapshot> snapshot() const { return std::atomic_load(&published); }
+
     Block getLatestBlock() const;
-    void minePendingTransactions(const std::string &miningRewardAddress, std::function<void(const std::string &, int)> onSample = nullptr);
-    bool addTransaction(const std::string &from, const std::string &to, double amount, std::string &error);
+    // 채굴한 블록을 돌려준다 (체인에 들어간 블록이라 주소가 유지된다).
+    // 채굴하는 동안 다른 블록이 체인에 붙으면 바로 멈추고 새 팁 위에서 템플릿을 다시 만든다.
+    // cancel이 켜지면 멈추고 nullptr
+    const Block *minePendingTransactions(const std::string &miningRewardAddress, std::function<void(const Hash256 &, int)> onSample = nullptr,
+                                         const std::atomic<bool> *cancel = nullptr);
+    // 성공하면 만든 트랜잭션을 created에 복사한다
+    bool addTransaction(const std::string &from, const std::string &to, double amount, std::string &error,
+                        std::optional<UTXOTransaction> *created = nullptr);
 
     bool isChainValid() const;
 
-    const std::vector<Block> &getChain() const { return chain; }
-    int getDifficulty() const { return difficulty; }
-    void setDifficulty(int diff) { difficulty = diff; }
+    // 다른 스레드가 블록을 붙이는 중일 수 있으므로 snapshot()->height 안쪽만 읽는다
+    const ChainStore &getChain() const { return chain; }
+    int getDifficulty() const { return snapshot()->difficulty; }
+    void setDifficulty(int diff);
 
     void setBlockTimeTarget(int seconds) { blockTimeTarget = seconds; }
     void setDifficultyAdjustmentInterval(int blocks) { difficultyAdjustmentInterval = blocks; }
+    void setMiningThreads(unsigned threads) { miningThreads = threads; }
+    unsigned getMiningThreads() const { return miningThreads; }
 
     void adjustDifficulty();
     int calculateNewDifficulty() const;
 
     std::unordered_map<std::string, double> getBalances() const;
-    const std::vector<UTXOTransaction> &getPendingTransactions() const { return pendingTransactions; }
-    std::vector<std::tuple<std::string, int, TxOutput>> getUTXOs() const;
+    std::vector<std::pair<OutPoint, TxOutput>> getUTXOs() const;
 
     bool saveToFile(const std::string &path) const;
     bool loadFromFile(const std::string &path);
+    // 블록 로그를 재생해 체인을 복원한다. 로그가 비어 있으면 체인은 그대로 두고 true,
+    // 열 수 없거나 손상되었으면 false. 스냅샷이 연결되어 있고 체인과 맞으면 그 이후 블록만 재생한다.
+    bool loadFromLog(BlockLog &log);
+    // 현재 체인 전체와 난이도를 (빈) 로그에 기록한다. 새 로그 생성과 chain.dat 이전에 쓴다.
+    bool writeToLog(BlockLog &log) const;
+    // DB에 빠진 블록(스키마 업그레이드, DB 삭제 등)을 체인에서 한 트랜잭션으로 채운다
+    void backfillDatabase(Database &db) const;
+    // 저장해 둔 mempool을 다시 넣는다. 입력이 이미 쓰였거나 다른 pending과 겹치는 트랜잭션은 버리고 그 id를 돌려준다
+    std::vector<Hash256> restoreMempool(std::vector<UTXOTransaction> saved);
+    // 지금까지 넘긴 쓰기가 모두 기록될 때까지 기다린다. 파이프라인이 없거나 모두 성공했으면 true
+    bool waitDurable();
     bool acceptExternalBlock(const Block &block);
-    void addExternalPending(const UTXOTransaction &tx);
+    // 이미 mempool에 있는 트랜잭션이면 넣지 않고 false
+    bool addExternalPending(const UTXOTransaction &tx);
 
 private:
-    bool isUTXOInPending(const std::string &txId, int index) const;
-    void applyTransactionToUTXOSet(const UTXOTransaction &tx);
-    void rebuildUTXOFromChain();
+    // 아래는 writeMutex를 잡은 채로 부른다
+    bool isUTXOInPending(const OutPoint &outPoint) const;
+    void trackPendingInputs(const UTXOTransaction &tx);
+    void untrackPendingInputs(const UTXOTransaction &tx);
+    // included에 든 트랜잭션을 mempool에서 빼고 (persistence가 있으면) 그 변경을 넘긴다
+    void removeMinedPending(const std::unordered_set<Hash256, Hash256Hasher> &included);
+    void applyTransactionToUTXOSet(UTXOSet &set, const UTXOTransaction &tx, UTXOSet::UndoLog *undo = nullptr);
+    void rebuildUTXOFromChain() { replayUTXOFrom(0); }
+    // first번째 블록부터 끝까지 utxoSet에 적용한다 (시작할 때만, 0이면 새 집합에서 시작한다)
+    void replayUTXOFrom(size_t first);
+    bool restoreUTXOSnapshot();
+    void maybeSnapshot();
+    void applyBlockViewToUTXOSet(const BlockView &view);
+    // 블록 하나를 적용할 쓰기용 UTXO 사본 (재사용할 수 있으면 이전 버전, 아니면 현재 버전의 복사)
+    std::shared_ptr<UTXOSet> beginUTXOUpdate();
+    // 적용한 사본을 현재 버전으로 바꾼다. undo는 그 적용에서 바뀐 outpoint 기록
+    void commitUTXOUpdate(std::shared_ptr<UTXOSet> next, const UTXOSet::UndoLog &undo);
+    void setDifficultyLocked(int diff);
+    void adjustDifficultyLocked();
+    Hash256 tipHash() const;
+    // 현재 상태로 새 스냅샷을 발행한다
+    void publish();
 };
 
 #endif
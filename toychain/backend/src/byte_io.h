@@ -0,0 +1,32 @@
+#ifndef BYTE_IO_H
+#define BYTE_IO_H
+
+#include <cstdint>
+#include <string>
+
+// 저장 형식(블록 로그, UTXO 스냅샷)에 쓰는 little-endian 정수 읽기/쓰기
+
+inline uint32_t loadLE32(const unsigned char *p)
+{
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline uint64_t loadLE64(const unsigned char *p)
+{
+    return static_cast<uint64_t>(loadLE32(p)) | (static_cast<uint64_t>(loadLE32(p + 4)) << 32);
+}
+
+inline void putLE32(std::string &out, uint32_t v)
+{
+    char b[4] = {static_cast<char>(v), static_cast<char>(v >> 8), static_cast<char>(v >> 16), static_cast<char>(v >> 24)};
+    out.append(b, 4);
+}
+
+inline void putLE64(std::string &out, uint64_t v)
+{
+    putLE32(out, static_cast<uint32_t>(v));
+    putLE32(out, static_cast<uint32_t>(v >> 32));
+}
+
+#endif
@@ -0,0 +1,263 @@
+#include "chain_json.h"
+#include <charconv>
+
+namespace
+{
+    Hash256 readHash(JsonReader &r)
+    {
+        try
+        {
+            return Hash256::fromHex(r.string());
+        }
+        catch (const std::invalid_argument &e)
+        {
+            r.fail(e.what());
+        }
+    }
+
+    void require(const JsonReader &r, bool present, const char *what)
+    {
+        if (!present)
+            r.fail(what);
+    }
+
+    void writeHeaderFields(JsonWriter &w, int index, long long timestamp, const Hash256 &hash,
+                           const Hash256 &previousHash, int nonce, int difficulty)
+    {
+        w.field("index", index)
+            .field("timestamp", timestamp)
+            .field("hash", hash)
+            .field("previousHash", previousHash)
+            .field("nonce", nonce)
+            .field("difficulty", difficulty);
+    }
+}
+
+void writeJson(JsonWriter &w, const TxInput &input)
+{
+    w.beginObject()
+        .field("txId", input.txId)
+        .field("outputIndex", input.outputIndex)
+        .field("signature", input.signature)
+        .endObject();
+}
+
+void writeJson(JsonWriter &w, const TxOutput &output)
+{
+    w.beginObject()
+        .field("address", output.address)
+        .field("amount", output.amount)
+        .endObject();
+}
+
+void writeJson(JsonWriter &w, const UTXOTransaction &tx)
+{
+    w.beginObject()
+        .field("id", tx.getId())
+        .key("inputs")
+        .array(tx.getInputs())
+        .key("outputs")
+        .array(tx.getOutputs())
+        .endObject();
+}
+
+void writeJson(JsonWriter &w, const Block &block)
+{
+    w.beginObject();
+    writeHeaderFields(w, block.getIndex(), block.getTimestamp(), block.getHash(), block.getPreviousHash(),
+                      block.getNonce(), block.getDifficulty());
+    w.key("transactions").array(block.getTransactions()).endObject();
+}
+
+void writeJson(JsonWriter &w, const std::pair<OutPoint, TxOutput> &utxo)
+{
+    w.beginObject()
+        .field("txId", utxo.first.txId)
+        .field("index", utxo.first.index)
+        .field("address", utxo.second.address)
+        .field("amount", utxo.second.amount)
+        .endObject();
+}
+
+void writeJson(JsonWriter &w, const MiningSample &sample)
+{
+    static const char HEX[] = "0123456789abcdef";
+    char text[16 + 2 * Sha256::DIGEST_SIZE];
+    char *p = std::to_chars(text, text + 16, sample.nonce).ptr;
+    *p++ = ':';
+    if (sample.hash.isNull())
+        *p++ = '0'; // Hash256::toHex와 같은 표기
+    else
+    {
+        for (unsigned char byte : sample.hash.bytes)
+        {
+            *p++ = HEX[byte >> 4];
+            *p++ = HEX[byte & 0x0f];
+        }
+    }
+    w.value(std::string_view(text, (size_t)(p - text)));
+}
+
+void writeJson(JsonWriter &w, const std::unordered_map<std::string, double> &balances)
+{
+    w.beginObject();
+    for (const auto &[address, balance] : balances)
+        w.field(address, balance);
+    w.endObject();
+}
+
+void writeBlockHeaderJson(JsonWriter &w, const Block &block)
+{
+    w.beginObject();
+    writeHeaderFields(w, block.getIndex(), block.getTimestamp(), block.getHash(), block.getPreviousHash(),
+                      block.getNonce(), block.getDifficulty());
+    w.field("txCount", block.getTransactions().size()).endObject();
+}
+
+void writeBlockHeaderJson(JsonWriter &w, const BlockView &view)
+{
+    w.beginObject();
+    writeHeaderFields(w, view.getIndex(), view.getTimestamp(), view.getHash(), view.getPreviousHash(),
+                      view.getNonce(), view.getDifficulty());
+    w.field("txCount", view.getTxCount()).endObject();
+}
+
+TxInput readTxInputJson(JsonReader &r)
+{
+    Hash256 txId;
+    int outputIndex = 0;
+    std::string signature;
+    bool hasTxId = false, hasIndex = false;
+    r.object([&](std::string_view key)
+             {
+        if (key == "txId")
+        {
+            txId = readHash(r);
+            hasTxId = true;
+        }
+        else if (key == "outputIndex")
+        {
+            outputIndex = r.integer<int>();
+            hasIndex = true;
+        }
+        else if (key == "signature")
+            signature = r.string();
+        else
+            return false;
+        return true; });
+    require(r, hasTxId && hasIndex, "input needs txId and outputIndex");
+    return TxInput(txId, outputIndex, signature);
+}
+
+TxOutput readTxOutputJson(JsonReader &r)
+{
+    TxOutput output;
+    bool hasAddress = false, hasAmount = false;
+    r.object([&](std::string_view key)
+             {
+        if (key == "address")
+        {
+            output.address = r.string();
+            hasAddress = true;
+        }
+        else if (key == "amount")
+        {
+            output.amount = r.number();
+            hasAmount = true;
+        }
+        else
+            return false;
+        return true; });
+    require(r, hasAddress && hasAmount, "output needs address and amount");
+    return output;
+}
+
+UTXOTransaction readTransactionJson(JsonReader &r)
+{
+    Hash256 id;
+    bool hasId = false;
+    std::vector<TxInput> inputs;
+    std::vector<TxOutput> outputs;
+    r.object([&](std::string_view key)
+             {
+        if (key == "id" || key == "tx_id")
+        {
+            id = readHash(r);
+            hasId = true;
+        }
+        else if (key == "inputs")
+            r.array([&]()
+                    { inputs.push_back(readTxInputJson(r)); });
+        else if (key == "outputs")
+            r.array([&]()
+                    { outputs.push_back(readTxOutputJson(r)); });
+        else
+            return false;
+        return true; });
+    require(r, hasId, "transaction needs id");
+    return UTXOTransaction(id, std::move(inputs), std::move(outputs));
+}
+
+Block readBlockJson(JsonReader &r, const std::function<bool(std::string_view, JsonReader &)> &extra)
+{
+    BlockHeader header{};
+    Hash256 hash;
+    std::vector<UTXOTransaction> txs;
+    unsigned seen = 0; // 필수 필드 6개
+    r.object([&](std::string_view key)
+             {
+        if (key == "index")
+        {
+            header.index = r.integer<int32_t>();
+            seen |= 1;
+        }
+        else if (key == "timestamp")
+        {
+            header.timestamp = r.integer<int64_t>();
+            seen |= 2;
+        }
+        else if (key == "nonce")
+        {
+            header.nonce = r.integer<int32_t>();
+            seen |= 4;
+        }
+        else if (key == "difficulty")
+        {
+            header.difficulty = r.integer<int32_t>();
+            seen |= 8;
+        }
+        else if (key == "previousHash")
+        {
+            header.previousHash = readHash(r);
+            seen |= 16;
+        }
+        else if (key == "hash")
+        {
+            hash = readHash(r);
+            seen |= 32;
+        }
+        else if (key == "transactions")
+            r.array([&]()
+                    { txs.push_back(readTransactionJson(r)); });
+        else
+            return extra && extra(key, r);
+        return true; });
+    require(r, seen == 63, "block needs index, timestamp, nonce, difficulty, previousHash and hash");
+    return Block(header, std::move(txs), hash);
+}
+
+UTXOTransaction parseTransactionJson(std::string_view json)
+{
+    JsonReader r(json);
+    UTXOTransaction tx = readTransactionJson(r);
+    r.finish();
+    return tx;
+}
+
+Block parseBlockJson(std::string_view json, const std::function<bool(std::string_view, JsonReader &)> &extra)
+{
+    JsonReader r(json);
+    Block block = readBlockJson(r, extra);
+    r.finish();
+    return block;
+}
@@ -0,0 +1,57 @@
+#ifndef CHAIN_JSON_H
+#define CHAIN_JSON_H
+
+#include "block.h"
+#include "chain_store.h"
+#include "json_reader.h"
+#include "json_writer.h"
+#include "sample_ring.h"
+#include "utxo.h"
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+// 블록/트랜잭션/UTXO의 JSON 표현. REST 응답과 피어 전파가 모두 이것을 쓴다.
+//   tx:     {"id","inputs":[{"txId","outputIndex","signature"}],"outputs":[{"address","amount"}]}
+//   block:  {"index","timestamp","hash","previousHash","nonce","difficulty","transactions":[tx...]}
+//   header: block에서 transactions 대신 "txCount"
+//   utxo:   {"txId","index","address","amount"}
+void writeJson(JsonWriter &w, const TxInput &input);
+void writeJson(JsonWriter &w, const TxOutput &output);
+void writeJson(JsonWriter &w, const UTXOTransaction &tx);
+void writeJson(JsonWriter &w, const Block &block);
+void writeJson(JsonWriter &w, const std::pair<OutPoint, TxOutput> &utxo);
+// "nonce:hash" 문자열
+void writeJson(JsonWriter &w, const MiningSample &sample);
+// 주소 → 잔액 객체
+void writeJson(JsonWriter &w, const std::unordered_map<std::string, double> &balances);
+
+void writeBlockHeaderJson(JsonWriter &w, const Block &block);
+// 로그 레코드에서 Block을 만들지 않고 바로 쓴다
+void writeBlockHeaderJson(JsonWriter &w, const BlockView &view);
+
+// 같은 표현을 읽는다. 필드 순서는 상관없고 모르는 필드는 건너뛴다.
+// 트랜잭션 id는 "tx_id"도 받는다. 필수 필드가 없거나 형식이 틀리면 JsonError
+TxInput readTxInputJson(JsonReader &r);
+TxOutput readTxOutputJson(JsonReader &r);
+UTXOTransaction readTransactionJson(JsonReader &r);
+// 블록의 해시는 다시 계산하지 않고 받은 값을 쓴다.
+// extra는 블록 필드가 아닌 키를 받는다 (값을 읽었으면 true, 아니면 건너뛴다)
+Block readBlockJson(JsonReader &r, const std::function<bool(std::string_view, JsonReader &)> &extra = nullptr);
+
+// 본문 전체가 값 하나여야 한다
+UTXOTransaction parseTransactionJson(std::string_view json);
+Block parseBlockJson(std::string_view json, const std::function<bool(std::string_view, JsonReader &)> &extra = nullptr);
+
+// 한 번 쓰고 마는 곳(피어 전파 등)을 위한 편의 함수
+template <typename T>
+std::string toJson(const T &item)
+{
+    std::string out;
+    JsonWriter(out).value(item);
+    return out;
+}
+
+#endif
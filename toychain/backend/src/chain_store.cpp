@@ -0,0 +1,188 @@
+#include "chain_store.h"
+#include "storage.h"
+#include <stdexcept>
+#include <sys/mman.h>
+
+namespace
+{
+    void need(const unsigned char *p, const unsigned char *limit, size_t n)
+    {
+        if (static_cast<size_t>(limit - p) < n)
+            throw std::runtime_error("truncated block record");
+    }
+
+    Hash256 hashAt(const unsigned char *p)
+    {
+        Hash256 h;
+        std::memcpy(h.data(), p, Sha256::DIGEST_SIZE);
+        return h;
+    }
+}
+
+// MappedFile
+std::shared_ptr<MappedFile> MappedFile::map(int fd, size_t length)
+{
+    if (length == 0)
+        return nullptr;
+    void *addr = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED)
+        return nullptr;
+    return std::shared_ptr<MappedFile>(new MappedFile(addr, length));
+}
+
+MappedFile::~MappedFile()
+{
+    ::munmap(addr, length);
+}
+
+// TxView
+TxView::TxView(const unsigned char *begin, const unsigned char *limit)
+    : p(begin)
+{
+    const unsigned char *q = begin;
+    need(q, limit, Sha256::DIGEST_SIZE + 8);
+    q += Sha256::DIGEST_SIZE + 8;
+
+    for (uint32_t i = 0, n = inputCount(); i < n; ++i)
+    {
+        need(q, limit, Sha256::DIGEST_SIZE + 8);
+        uint32_t sigLen = loadLE32(q + Sha256::DIGEST_SIZE + 4);
+        q += Sha256::DIGEST_SIZE + 8;
+        need(q, limit, sigLen);
+        q += sigLen;
+    }
+    outputs = q;
+    for (uint32_t i = 0, n = outputCount(); i < n; ++i)
+    {
+        need(q, limit, 12);
+        uint32_t addrLen = loadLE32(q + 8);
+        q += 12;
+        need(q, limit, addrLen);
+        q += addrLen;
+    }
+    last = q;
+}
+
+Hash256 TxView::id() const
+{
+    return hashAt(p);
+}
+
+UTXOTransaction TxView::toTransaction() const
+{
+    std::vector<TxInput> inputs;
+    inputs.reserve(inputCount());
+    forEachInput([&](const unsigned char *txId, int outputIndex, std::string_view signature)
+                 { inputs.emplace_back(hashAt(txId), outputIndex, std::string(signature)); });
+
+    std::vector<TxOutput> outputs;
+    outputs.reserve(outputCount());
+    forEachOutput([&](double amount, std::string_view address)
+                  { outputs.emplace_back(amount, std::string(address)); });
+
+    return UTXOTransaction(id(), std::move(inputs), std::move(outputs));
+}
+
+// BlockView
+BlockView::BlockView(const unsigned char *payload, size_t len)
+    : p(payload), limit(payload + len)
+{
+    need(p, limit, HEADER_SIZE);
+}
+
+Hash256 BlockView::getPreviousHash() const
+{
+    return hashAt(p + 20);
+}
+
+Hash256 BlockView::getHash() const
+{
+    return hashAt(p + 20 + Sha256::DIGEST_SIZE);
+}
+
+Block BlockView::toBlock() const
+{
+    BlockHeader header{};
+    header.index = getIndex();
+    header.timestamp = getTimestamp();
+    header.nonce = getNonce();
+    header.difficulty = getDifficulty();
+    header.previousHash = getPreviousHash();
+
+    std::vector<UTXOTransaction> txs;
+    txs.reserve(getTxCount());
+    const unsigned char *end = p + HEADER_SIZE;
+    forEachTransaction([&](const TxView &tx)
+                       {
+        txs.push_back(tx.toTransaction());
+        end = tx.end(); });
+    if (end != limit)
+        throw std::runtime_error("trailing bytes in block record");
+
+    return Block(header, std::move(txs), getHash());
+}
+
+// ChainStore
+ChainStore::~ChainStore()
+{
+    clear();
+}
+
+const Block &ChainStore::operator[](size_t i) const
+{
+    const Block *block = slots[i].load(std::memory_order_acquire);
+    if (block)
+        return *block;
+
+    // 아직 레코드로만 있는 블록: 만들어서 설치한다. 다른 스레드가 먼저 설치했으면 그것을 쓴다.
+    verify(i);
+    auto fresh = std::make_unique<Block>(view(i).toBlock());
+    const Block *expected = nullptr;
+    if (slots[i].compare_exchange_strong(expected, fresh.get(), std::memory_order_acq_rel))
+        return *fresh.release();
+    return *expected;
+}
+
+void ChainStore::push_back(const Block &block)
+{
+    slots.emplace_back(new Block(block));
+}
+
+void ChainStore::assign(std::vector<Block> blocks)
+{
+    clear();
+    for (auto &block : blocks)
+        slots.emplace_back(new Block(std::move(block)));
+}
+
+void ChainStore::assign(MappedBlocks blocks)
+{
+    clear();
+    mapped = std::move(blocks);
+    for (size_t i = 0; i < mapped.offsets.size(); ++i)
+        slots.emplace_back(nullptr);
+}
+
+void ChainStore::clear()
+{
+    for (size_t i = 0; i < slots.size(); ++i)
+        delete slots[i].load(std::memory_order_relaxed);
+    slots.clear();
+    mapped = MappedBlocks();
+}
+
+BlockView ChainStore::view(size_t i) const
+{
+    const unsigned char *record = mapped.file->data() + mapped.offsets[i];
+    uint32_t length = loadLE32(record);
+    // record: length | crc | type | payload
+    return BlockView(record + 9, length - 1);
+}
+
+void ChainStore::verify(size_t i) const
+{
+    const unsigned char *record = mapped.file->data() + mapped.offsets[i];
+    uint32_t length = loadLE32(record);
+    if (computeCrc32(record + 8, length) != loadLE32(record + 4))
+        throw std::runtime_error("corrupted block record at height " + std::to_string(i));
+}
@@ -0,0 +1,200 @@
+#ifndef CHAIN_STORE_H
+#define CHAIN_STORE_H
+
+#include "append_vector.h"
+#include "block.h"
+#include "byte_io.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 읽기 전용으로 mmap한 파일 영역. 매핑을 참조하는 view들이 shared_ptr로 함께 붙잡는다.
+class MappedFile
+{
+public:
+    // fd의 앞 length 바이트를 매핑한다. 실패하면 nullptr
+    static std::shared_ptr<MappedFile> map(int fd, size_t length);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const unsigned char *data() const { return static_cast<const unsigned char *>(addr); }
+    size_t size() const { return length; }
+
+private:
+    MappedFile(void *addr, size_t length) : addr(addr), length(length) {}
+
+    void *addr;
+    size_t length;
+};
+
+// 블록 레코드 안의 트랜잭션 하나에 대한 zero-copy view.
+// 생성할 때 범위를 한 번 검사하므로(벗어나면 std::runtime_error) 이후 접근은 검사 없이 읽는다.
+class TxView
+{
+public:
+    TxView(const unsigned char *begin, const unsigned char *limit);
+
+    Hash256 id() const;
+    uint32_t inputCount() const { return loadLE32(p + Sha256::DIGEST_SIZE); }
+    uint32_t outputCount() const { return loadLE32(p + Sha256::DIGEST_SIZE + 4); }
+    // 이 트랜잭션 바로 다음 바이트
+    const unsigned char *end() const { return last; }
+
+    // fn(const unsigned char *txId, int outputIndex, std::string_view signature)
+    template <typename Fn>
+    void forEachInput(Fn &&fn) const
+    {
+        const unsigned char *q = p + Sha256::DIGEST_SIZE + 8;
+        for (uint32_t i = 0, n = inputCount(); i < n; ++i)
+        {
+            const unsigned char *txId = q;
+            int outputIndex = static_cast<int32_t>(loadLE32(q + Sha256::DIGEST_SIZE));
+            uint32_t sigLen = loadLE32(q + Sha256::DIGEST_SIZE + 4);
+            q += Sha256::DIGEST_SIZE + 8;
+            fn(txId, outputIndex, std::string_view(reinterpret_cast<const char *>(q), sigLen));
+            q += sigLen;
+        }
+    }
+
+    // fn(double amount, std::string_view address)
+    template <typename Fn>
+    void forEachOutput(Fn &&fn) const
+    {
+        const unsigned char *q = outputs;
+        for (uint32_t i = 0, n = outputCount(); i < n; ++i)
+        {
+            uint64_t bits = loadLE64(q);
+            double amount;
+            std::memcpy(&amount, &bits, sizeof(amount));
+            uint32_t addrLen = loadLE32(q + 8);
+            q += 12;
+            fn(amount, std::string_view(reinterpret_cast<const char *>(q), addrLen));
+            q += addrLen;
+        }
+    }
+
+    UTXOTransaction toTransaction() const;
+
+private:
+    const unsigned char *p;
+    const unsigned char *outputs;
+    const unsigned char *last;
+};
+
+// 블록 로그의 블록 레코드(payload)에 대한 zero-copy view. 고정 헤더 필드는 파싱 없이 바로 읽는다.
+class BlockView
+{
+public:
+    static constexpr size_t HEADER_SIZE = 88; // index, timestamp, nonce, difficulty, prevHash, hash, txCount
+
+    // len이 헤더보다 짧으면 std::runtime_error
+    BlockView(const unsigned char *payload, size_t len);
+
+    int getIndex() const { return static_cast<int32_t>(loadLE32(p)); }
+    long long getTimestamp() const { return static_cast<int64_t>(loadLE64(p + 4)); }
+    int getNonce() const { return static_cast<int32_t>(loadLE32(p + 12)); }
+    int getDifficulty() const { return static_cast<int32_t>(loadLE32(p + 16)); }
+    Hash256 getPreviousHash() const;
+    Hash256 getHash() const;
+    uint32_t getTxCount() const { return loadLE32(p + 84); }
+
+    // fn(const TxView &)
+    template <typename Fn>
+    void forEachTransaction(Fn &&fn) const
+    {
+        const unsigned char *q = p + HEADER_SIZE;
+        for (uint32_t t = 0, n = getTxCount(); t < n; ++t)
+        {
+            TxView tx(q, limit);
+            fn(tx);
+            q = tx.end();
+        }
+    }
+
+    Block toBlock() const;
+
+private:
+    const unsigned char *p;
+    const unsigned char *limit;
+};
+
+// 블록 로그를 열 때 만들어지는 매핑과 블록 레코드 위치 목록
+struct MappedBlocks
+{
+    std::shared_ptr<MappedFile> file;
+    std::vector<size_t> offsets; // 각 블록 레코드(length prefix)의 파일 내 위치
+};
+
+// 체인의 블록 목록.
+// 로그에서 읽은 블록은 mmap된 레코드로만 들고 있다가 처음 접근될 때 CRC를 확인하고 Block으로 만든다.
+// 그래서 시작할 때는 체인 높이와 상관없이 Block/트랜잭션을 하나도 만들지 않는다.
+// 만들어진 Block은 주소가 바뀌지 않는다. reader는 size()로 본 높이 안쪽이면 writer의 push_back과 겹쳐도
+// 잠금 없이 읽을 수 있다 (assign/clear는 reader가 없을 때만).
+class ChainStore
+{
+public:
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Block;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Block *;
+        using reference = const Block &;
+
+        const_iterator(const ChainStore *store, size_t i) : store(store), i(i) {}
+        reference operator*() const { return (*store)[i]; }
+        pointer operator->() const { return &(*store)[i]; }
+        const_iterator &operator++()
+        {
+            ++i;
+            return *this;
+        }
+        bool operator==(const const_iterator &other) const { return i == other.i; }
+        bool operator!=(const const_iterator &other) const { return i != other.i; }
+
+    private:
+        const ChainStore *store;
+        size_t i;
+    };
+
+    ChainStore() = default;
+    ~ChainStore();
+
+    ChainStore(const ChainStore &) = delete;
+    ChainStore &operator=(const ChainStore &) = delete;
+
+    size_t size() const { return slots.size(); }
+    bool empty() const { return slots.empty(); }
+    const Block &operator[](size_t i) const;
+    const Block &front() const { return (*this)[0]; }
+    const Block &back() const { return (*this)[size() - 1]; }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+    void push_back(const Block &block);
+    void assign(std::vector<Block> blocks);
+    void assign(MappedBlocks blocks);
+    void clear();
+
+    // i번째 블록이 로그 레코드에서 왔는지 (그렇다면 view로 바로 읽을 수 있다)
+    bool isMapped(size_t i) const { return i < mapped.offsets.size(); }
+    // isMapped(i)일 때만 사용. verify를 먼저 하지 않으면 CRC는 확인하지 않는다.
+    BlockView view(size_t i) const;
+    // 레코드 CRC 확인. 맞지 않으면 std::runtime_error
+    void verify(size_t i) const;
+
+private:
+    MappedBlocks mapped;
+    mutable AppendVector<std::atomic<const Block *>> slots;
+};
+
+#endif
@@ -1 +1,613 @@
-// ...existing code from src/crypto.cpp...
\ No newline at end of file
+#include "crypto.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    const uint32_t K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+    inline uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+    inline uint32_t loadBE32(const unsigned char *p)
+    {
+        return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+    }
+
+    inline void storeBE32(unsigned char *p, uint32_t v)
+    {
+        p[0] = static_cast<unsigned char>(v >> 24);
+        p[1] = static_cast<unsigned char>(v >> 16);
+        p[2] = static_cast<unsigned char>(v >> 8);
+        p[3] = static_cast<unsigned char>(v);
+    }
+
+    void compressScalar(uint32_t state[8], const unsigned char *block)
+    {
+        uint32_t w[64];
+        for (int i = 0; i < 16; ++i)
+            w[i] = loadBE32(block + i * 4);
+        for (int i = 16; i < 64; ++i)
+        {
+            uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; ++i)
+        {
+            uint32_t S1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+            uint32_t ch = (e & f) ^ (~e & g);
+            uint32_t t1 = h + S1 + ch + K[i] + w[i];
+            uint32_t S0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+            uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            uint32_t t2 = S0 + maj;
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+
+#define TOYCHAIN_ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+    // N개의 독립 메시지 블록을 한 번에 압축한다. state는 word-major 배치 (state[word * N + lane]).
+    // V는 GCC/Clang vector extension 타입이며, target 속성이 붙은 함수 안으로 인라인되어
+    // 그 ISA(SSE4.1/AVX2/AVX-512) 명령으로 컴파일된다.
+    template <typename V, size_t N>
+    __attribute__((always_inline)) inline void transformLanes(uint32_t *state, const unsigned char *const *blocks)
+    {
+        V w[16];
+        for (int i = 0; i < 16; ++i)
+        {
+            alignas(64) uint32_t words[N];
+            for (size_t l = 0; l < N; ++l)
+                words[l] = loadBE32(blocks[l] + i * 4);
+            std::memcpy(&w[i], words, sizeof(V));
+        }
+
+        V s[8];
+        std::memcpy(s, state, sizeof(s));
+        V a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+
+#pragma GCC unroll 64
+        for (int i = 0; i < 64; ++i)
+        {
+            if (i >= 16)
+            {
+                V w15 = w[(i - 15) & 15];
+                V w2 = w[(i - 2) & 15];
+                V s0 = TOYCHAIN_ROTR(w15, 7) ^ TOYCHAIN_ROTR(w15, 18) ^ (w15 >> 3);
+                V s1 = TOYCHAIN_ROTR(w2, 17) ^ TOYCHAIN_ROTR(w2, 19) ^ (w2 >> 10);
+                w[i & 15] = w[i & 15] + s0 + w[(i - 7) & 15] + s1;
+            }
+            V S1 = TOYCHAIN_ROTR(e, 6) ^ TOYCHAIN_ROTR(e, 11) ^ TOYCHAIN_ROTR(e, 25);
+            V ch = (e & f) ^ (~e & g);
+            V t1 = h + S1 + ch + K[i] + w[i & 15];
+            V S0 = TOYCHAIN_ROTR(a, 2) ^ TOYCHAIN_ROTR(a, 13) ^ TOYCHAIN_ROTR(a, 22);
+            V maj = (a & b) ^ (a & c) ^ (b & c);
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + S0 + maj;
+        }
+
+        s[0] += a;
+        s[1] += b;
+        s[2] += c;
+        s[3] += d;
+        s[4] += e;
+        s[5] += f;
+        s[6] += g;
+        s[7] += h;
+        std::memcpy(state, s, sizeof(s));
+    }
+
+#undef TOYCHAIN_ROTR
+
+    typedef uint32_t U32x4 __attribute__((vector_size(16)));
+    typedef uint32_t U32x8 __attribute__((vector_size(32)));
+    typedef uint32_t U32x16 __attribute__((vector_size(64)));
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TOYCHAIN_SHA256_X86 1
+
+    __attribute__((target("sse4.1"))) void transform4(uint32_t *state, const unsigned char *const *blocks)
+    {
+        transformLanes<U32x4, 4>(state, blocks);
+    }
+
+    __attribute__((target("avx2"))) void transform8(uint32_t *state, const unsigned char *const *blocks)
+    {
+        transformLanes<U32x8, 8>(state, blocks);
+    }
+
+    __attribute__((target("avx512f"))) void transform16(uint32_t *state, const unsigned char *const *blocks)
+    {
+        transformLanes<U32x16, 16>(state, blocks);
+    }
+
+    // Intel SHA extensions: 단일 메시지 압축을 하드웨어 명령으로 처리
+    __attribute__((target("sha,sse4.1"))) void compressShaNi(uint32_t state[8], const unsigned char *block)
+    {
+        const __m128i shuffleMask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+        __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&state[0]));
+        __m128i state1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&state[4]));
+        tmp = _mm_shuffle_epi32(tmp, 0xB1);                 // CDAB
+        state1 = _mm_shuffle_epi32(state1, 0x1B);           // EFGH
+        __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);   // ABEF
+        state1 = _mm_blend_epi16(state1, tmp, 0xF0);        // CDGH
+        const __m128i abefSave = state0;
+        const __m128i cdghSave = state1;
+
+        __m128i m[4];
+#pragma GCC unroll 16
+        for (int g = 0; g < 16; ++g)
+        {
+            if (g < 4)
+                m[g] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 16 * g)), shuffleMask);
+
+            __m128i msg = _mm_add_epi32(m[g & 3], _mm_loadu_si128(reinterpret_cast<const __m128i *>(&K[4 * g])));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+            if (g >= 3 && g <= 14)
+            {
+                __m128i t = _mm_alignr_epi8(m[g & 3], m[(g - 1) & 3], 4);
+                m[(g + 1) & 3] = _mm_sha256msg2_epu32(_mm_add_epi32(m[(g + 1) & 3], t), m[g & 3]);
+            }
+            msg = _mm_shuffle_epi32(msg, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+            if (g >= 1 && g <= 12)
+                m[(g - 1) & 3] = _mm_sha256msg1_epu32(m[(g - 1) & 3], m[g & 3]);
+        }
+
+        state0 = _mm_add_epi32(state0, abefSave);
+        state1 = _mm_add_epi32(state1, cdghSave);
+        tmp = _mm_shuffle_epi32(state0, 0x1B);              // FEBA
+        state1 = _mm_shuffle_epi32(state1, 0xB1);           // DCHG
+        state0 = _mm_blend_epi16(tmp, state1, 0xF0);        // DCBA
+        state1 = _mm_alignr_epi8(state1, tmp, 8);           // ABEF
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&state[0]), state0);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&state[4]), state1);
+    }
+
+    bool cpuHasShaNi()
+    {
+        unsigned eax, ebx, ecx, edx;
+        if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+            return false;
+        return (ebx & (1u << 29)) != 0 && __builtin_cpu_supports("sse4.1");
+    }
+#elif defined(__aarch64__)
+    // NEON은 aarch64 기본 ISA이므로 4-lane 경로를 항상 쓸 수 있다
+    void transform4(uint32_t *state, const unsigned char *const *blocks)
+    {
+        transformLanes<U32x4, 4>(state, blocks);
+    }
+#endif
+
+    struct Backend
+    {
+        const char *name;
+        size_t lanes;
+        void (*compress)(uint32_t state[8], const unsigned char *block);
+        void (*transform)(uint32_t *state, const unsigned char *const *blocks); // lanes > 1 일 때만
+    };
+
+    Backend selectBackend()
+    {
+        const Backend scalar{"scalar", 1, compressScalar, nullptr};
+        const char *forced = std::getenv("TOYCHAIN_SHA256");
+        std::string want = forced ? forced : "";
+
+#if defined(TOYCHAIN_SHA256_X86)
+        bool shani = cpuHasShaNi();
+        bool avx512 = __builtin_cpu_supports("avx512f");
+        bool avx2 = __builtin_cpu_supports("avx2");
+        bool sse4 = __builtin_cpu_supports("sse4.1");
+        auto single = shani ? compressShaNi : compressScalar;
+
+        if (want == "scalar")
+            return scalar;
+        if (want == "shani" && shani)
+            return {"sha-ni", 1, compressShaNi, nullptr};
+        if (want == "sse4" && sse4)
+            return {"sse4.1x4", 4, single, transform4};
+        if (want == "avx2" && avx2)
+            return {"avx2x8", 8, single, transform8};
+        if ((want.empty() || want == "avx512") && avx512)
+            return {"avx512x16", 16, single, transform16};
+        // 16-lane이 없으면 단일 버퍼 SHA-NI가 AVX2 8-lane보다 빠르다
+        if (shani)
+            return {"sha-ni", 1, compressShaNi, nullptr};
+        if (avx2)
+            return {"avx2x8", 8, single, transform8};
+        if (sse4)
+            return {"sse4.1x4", 4, single, transform4};
+#elif defined(__aarch64__)
+        if (want != "scalar")
+            return {"neonx4", 4, compressScalar, transform4};
+#endif
+        return scalar;
+    }
+
+    const Backend &backend()
+    {
+        static const Backend selected = selectBackend();
+        return selected;
+    }
+
+    // 패딩까지 붙인 메시지 하나. 앞쪽과 뒤쪽 블록은 arena에 만들고, 그 사이 tail만으로 채워지는 블록은 tail을 그대로 가리킨다
+    struct LaneJob
+    {
+        uint32_t state[8];
+        size_t blocks;           // 전체 블록 수
+        size_t headOffset;       // arena 안에서 앞쪽 headBlocks개 블록의 위치
+        size_t headBlocks;
+        const unsigned char *direct; // tail 안을 바로 가리키는 directBlocks개 블록
+        size_t directBlocks;
+        size_t tailOffset;       // arena 안에서 나머지 블록의 위치
+        unsigned char *out;
+    };
+
+    inline const unsigned char *blockAt(const LaneJob &job, const std::vector<unsigned char> &arena, size_t b)
+    {
+        if (b < job.headBlocks)
+            return arena.data() + job.headOffset + b * Sha256::BLOCK_SIZE;
+        b -= job.headBlocks;
+        if (b < job.directBlocks)
+            return job.direct + b * Sha256::BLOCK_SIZE;
+        return arena.data() + job.tailOffset + (b - job.directBlocks) * Sha256::BLOCK_SIZE;
+    }
+
+    // 메시지 parts[0] + parts[1] + parts[2] 뒤에 SHA-256 패딩을 붙인 바이트열 중 [from, to)를 dst에 쓴다
+    void copyPadded(unsigned char *dst, const std::string_view (&parts)[3], size_t len, size_t blocks, uint64_t totalLen,
+                    size_t from, size_t to)
+    {
+        std::memset(dst, 0, to - from);
+        size_t pos = 0;
+        for (const auto &part : parts)
+        {
+            const size_t lo = std::max(pos, from);
+            const size_t hi = std::min(pos + part.size(), to);
+            if (lo < hi)
+                std::memcpy(dst + (lo - from), part.data() + (lo - pos), hi - lo);
+            pos += part.size();
+        }
+        if (len >= from && len < to)
+            dst[len - from] = 0x80;
+        const uint64_t bitLen = totalLen * 8;
+        for (size_t i = 0; i < 8; ++i)
+        {
+            const size_t at = blocks * Sha256::BLOCK_SIZE - 1 - i;
+            if (at >= from && at < to)
+                dst[at - from] = static_cast<unsigned char>(bitLen >> (8 * i));
+        }
+    }
+
+    // buffered(midstate에 남아 있던 바이트) + head + tail 메시지의 job을 만든다.
+    // 온전히 tail 바이트로만 된 블록은 arena에 복사하지 않는다
+    LaneJob makeJob(std::vector<unsigned char> &arena, std::string_view buffered, std::string_view head,
+                    std::string_view tail, uint64_t totalLen)
+    {
+        const size_t B = Sha256::BLOCK_SIZE;
+        const std::string_view parts[3] = {buffered, head, tail};
+        const size_t pre = buffered.size() + head.size();
+        const size_t len = pre + tail.size();
+
+        LaneJob job;
+        job.blocks = (len + 9 + B - 1) / B;
+        job.headBlocks = std::min(job.blocks, (pre + B - 1) / B);
+        job.directBlocks = len / B > job.headBlocks ? len / B - job.headBlocks : 0;
+        job.direct = job.directBlocks > 0 ? reinterpret_cast<const unsigned char *>(tail.data()) + (job.headBlocks * B - pre) : nullptr;
+
+        const size_t tailFrom = (job.headBlocks + job.directBlocks) * B;
+        job.headOffset = arena.size();
+        job.tailOffset = job.headOffset + job.headBlocks * B;
+        arena.resize(job.tailOffset + job.blocks * B - tailFrom);
+        copyPadded(arena.data() + job.headOffset, parts, len, job.blocks, totalLen, 0, job.headBlocks * B);
+        copyPadded(arena.data() + job.tailOffset, parts, len, job.blocks, totalLen, tailFrom, job.blocks * B);
+        return job;
+    }
+
+    // 블록 수가 비슷한 job끼리 lane을 채워 압축한다.
+    // 먼저 끝난 lane에는 더미 블록을 넣고, 마지막 블록 직후의 상태를 digest로 꺼낸다.
+    void runJobs(std::vector<LaneJob> &jobs, const std::vector<unsigned char> &arena)
+    {
+        const Backend &be = backend();
+        if (be.lanes == 1)
+        {
+            for (auto &job : jobs)
+            {
+                for (size_t b = 0; b < job.blocks; ++b)
+                    be.compress(job.state, blockAt(job, arena, b));
+                for (int i = 0; i < 8; ++i)
+                    storeBE32(job.out + i * 4, job.state[i]);
+            }
+            return;
+        }
+
+        std::sort(jobs.begin(), jobs.end(), [](const LaneJob &x, const LaneJob &y)
+                  { return x.blocks < y.blocks; });
+
+        const size_t n = be.lanes;
+        alignas(64) static const unsigned char dummy[Sha256::BLOCK_SIZE] = {0};
+        alignas(64) uint32_t state[8 * 16];
+        const unsigned char *ptrs[16];
+
+        for (size_t first = 0; first < jobs.size(); first += n)
+        {
+            size_t used = std::min(n, jobs.size() - first);
+            size_t maxBlocks = 0;
+            for (size_t l = 0; l < n; ++l)
+            {
+                for (int i = 0; i < 8; ++i)
+                    state[i * n + l] = l < used ? jobs[first + l].state[i] : 0;
+                if (l < used)
+                    maxBlocks = std::max(maxBlocks, jobs[first + l].blocks);
+            }
+
+            for (size_t b = 0; b < maxBlocks; ++b)
+            {
+                for (size_t l = 0; l < n; ++l)
+                {
+                    bool active = l < used && b < jobs[first + l].blocks;
+                    ptrs[l] = active ? blockAt(jobs[first + l], arena, b) : dummy;
+                }
+                be.transform(state, ptrs);
+                for (size_t l = 0; l < used; ++l)
+                {
+                    if (jobs[first + l].blocks == b + 1)
+                    {
+                        for (int i = 0; i < 8; ++i)
+                            storeBE32(jobs[first + l].out + i * 4, state[i * n + l]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+Sha256::Sha256() : bufferLen(0), totalLen(0)
+{
+    state[0] = 0x6a09e667;
+    state[1] = 0xbb67ae85;
+    state[2] = 0x3c6ef372;
+    state[3] = 0xa54ff53a;
+    state[4] = 0x510e527f;
+    state[5] = 0x9b05688c;
+    state[6] = 0x1f83d9ab;
+    state[7] = 0x5be0cd19;
+}
+
+void Sha256::update(const void *data, size_t len)
+{
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    totalLen += len;
+
+    if (bufferLen > 0)
+    {
+        size_t take = std::min(len, BLOCK_SIZE - bufferLen);
+        std::memcpy(buffer + bufferLen, p, take);
+        bufferLen += take;
+        p += take;
+        len -= take;
+        if (bufferLen < BLOCK_SIZE)
+            return;
+        backend().compress(state, buffer);
+        bufferLen = 0;
+    }
+
+    while (len >= BLOCK_SIZE)
+    {
+        backend().compress(state, p);
+        p += BLOCK_SIZE;
+        len -= BLOCK_SIZE;
+    }
+
+    if (len > 0)
+    {
+        std::memcpy(buffer, p, len);
+        bufferLen = len;
+    }
+}
+
+void Sha256::finish(unsigned char out[DIGEST_SIZE])
+{
+    uint64_t bitLen = totalLen * 8;
+
+    buffer[bufferLen++] = 0x80;
+    if (bufferLen > BLOCK_SIZE - 8)
+    {
+        std::memset(buffer + bufferLen, 0, BLOCK_SIZE - bufferLen);
+        backend().compress(state, buffer);
+        bufferLen = 0;
+    }
+    std::memset(buffer + bufferLen, 0, BLOCK_SIZE - 8 - bufferLen);
+    for (int i = 0; i < 8; ++i)
+        buffer[BLOCK_SIZE - 1 - i] = static_cast<unsigned char>(bitLen >> (8 * i));
+    backend().compress(state, buffer);
+
+    for (int i = 0; i < 8; ++i)
+        storeBE32(out + i * 4, state[i]);
+}
+
+void Sha256::hash(const void *data, size_t len, unsigned char out[DIGEST_SIZE])
+{
+    Sha256 ctx;
+    ctx.update(data, len);
+    ctx.finish(out);
+}
+
+std::string toHex(const unsigned char *data, size_t len)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string out(len * 2, '0');
+    for (size_t i = 0; i < len; ++i)
+    {
+        out[2 * i] = digits[data[i] >> 4];
+        out[2 * i + 1] = digits[data[i] & 0x0f];
+    }
+    return out;
+}
+
+std::string sha256Hex(const std::string &data)
+{
+    unsigned char digest[Sha256::DIGEST_SIZE];
+    Sha256::hash(data.data(), data.size(), digest);
+    return toHex(digest, sizeof(digest));
+}
+
+void Sha256::finishLanes(const Sha256 *bases, size_t baseStride, const std::string_view *heads,
+                         const std::string_view *tails, size_t tailStride, size_t count, Hash256 *out)
+{
+    thread_local std::vector<unsigned char> arena;
+    thread_local std::vector<LaneJob> jobs;
+    arena.clear();
+    jobs.clear();
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const Sha256 &base = bases[i * baseStride];
+        const std::string_view head = heads ? heads[i] : std::string_view();
+        const std::string_view tail = tails[i * tailStride];
+        LaneJob job = makeJob(arena, std::string_view(reinterpret_cast<const char *>(base.buffer), base.bufferLen), head, tail,
+                              base.totalLen + head.size() + tail.size());
+        std::memcpy(job.state, base.state, sizeof(job.state));
+        job.out = out[i].data();
+        jobs.push_back(job);
+    }
+    runJobs(jobs, arena);
+}
+
+void Sha256::finishMany(const Sha256 *bases, const std::string_view *tails, size_t count, Hash256 *out)
+{
+    finishLanes(bases, 1, nullptr, tails, 1, count, out);
+}
+
+void Sha256::finishMany(const Sha256 *bases, const std::string_view *heads, const std::string_view *tails, size_t count, Hash256 *out)
+{
+    finishLanes(bases, 1, heads, tails, 1, count, out);
+}
+
+void Sha256::finishMany(const std::string_view *tails, size_t count, Hash256 *out) const
+{
+    finishLanes(this, 0, nullptr, tails, 1, count, out);
+}
+
+void Sha256::finishMany(const std::string_view *heads, std::string_view tail, size_t count, Hash256 *out) const
+{
+    finishLanes(this, 0, heads, &tail, 0, count, out);
+}
+
+void Sha256::hashMany(const std::string_view *msgs, size_t count, Hash256 *out)
+{
+    Sha256 empty;
+    empty.finishMany(msgs, count, out);
+}
+
+const char *Sha256::backendName()
+{
+    return backend().name;
+}
+
+size_t Sha256::laneCount()
+{
+    return backend().lanes;
+}
+
+Hash256 sha256(const std::string &data)
+{
+    Hash256 h;
+    Sha256::hash(data.data(), data.size(), h.data());
+    return h;
+}
+
+bool Hash256::isNull() const
+{
+    for (unsigned char b : bytes)
+    {
+        if (b != 0)
+            return false;
+    }
+    return true;
+}
+
+bool Hash256::meetsDifficulty(int difficulty) const
+{
+    if (difficulty < 0 || difficulty > static_cast<int>(bytes.size() * 2))
+        return false;
+    int fullBytes = difficulty / 2;
+    for (int i = 0; i < fullBytes; ++i)
+    {
+        if (bytes[i] != 0)
+            return false;
+    }
+    return difficulty % 2 == 0 || (bytes[fullBytes] >> 4) == 0;
+}
+
+std::string Hash256::toHex() const
+{
+    if (isNull())
+        return "0";
+    return ::toHex(bytes.data(), bytes.size());
+}
+
+Hash256 Hash256::fromHex(std::string_view hex)
+{
+    Hash256 h;
+    if (hex == "0")
+        return h;
+    if (hex.size() != h.bytes.size() * 2)
+        throw std::invalid_argument("invalid hash length: " + std::string(hex));
+
+    auto nibble = [&hex](char c) -> int
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        throw std::invalid_argument("invalid hash: " + std::string(hex));
+    };
+    for (size_t i = 0; i < h.bytes.size(); ++i)
+    {
+        h.bytes[i] = static_cast<unsigned char>((nibble(hex[2 * i]) << 4) | nibble(hex[2 * i + 1]));
+    }
+    return h;
+}
@@ -0,0 +1,97 @@
+#ifndef CRYPTO_H
+#define CRYPTO_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+struct Hash256;
+
+// 스트리밍 SHA-256 (FIPS 180-4)
+// 상태가 평범한 값 타입이라 복사하면 그대로 midstate가 된다.
+// 고정 prefix를 update한 뒤 복사해 두면 이후에는 바뀌는 부분만 다시 해시할 수 있다.
+class Sha256
+{
+public:
+    static constexpr size_t DIGEST_SIZE = 32;
+    static constexpr size_t BLOCK_SIZE = 64;
+
+    Sha256();
+
+    void update(const void *data, size_t len);
+    void update(const std::string &data) { update(data.data(), data.size()); }
+    void finish(unsigned char out[DIGEST_SIZE]);
+
+    static void hash(const void *data, size_t len, unsigned char out[DIGEST_SIZE]);
+
+    // multi-buffer 해시: 서로 독립적인 메시지들을 SIMD lane에 하나씩 실어 함께 압축한다.
+    // out[i] = SHA256(msgs[i])
+    static void hashMany(const std::string_view *msgs, size_t count, Hash256 *out);
+    // out[i] = SHA256(bases[i]까지 입력된 내용 + tails[i]). 메시지마다 midstate가 다를 수 있다.
+    static void finishMany(const Sha256 *bases, const std::string_view *tails, size_t count, Hash256 *out);
+    // out[i] = SHA256(bases[i]까지 입력된 내용 + heads[i] + tails[i]). tails[i]의 온전한 블록은 복사하지 않고 그 자리에서 읽는다
+    static void finishMany(const Sha256 *bases, const std::string_view *heads, const std::string_view *tails, size_t count, Hash256 *out);
+    // out[i] = SHA256(이 컨텍스트까지 입력된 내용 + tails[i]). 하나의 midstate에서 갈라지는 채굴용
+    void finishMany(const std::string_view *tails, size_t count, Hash256 *out) const;
+    // out[i] = SHA256(이 컨텍스트까지 입력된 내용 + heads[i] + tail). 짧은 head(nonce)만 다르고 긴 tail을 함께 쓰는 채굴용.
+    // lane마다 tail을 복사하지 않는다
+    void finishMany(const std::string_view *heads, std::string_view tail, size_t count, Hash256 *out) const;
+
+    // 실행 중인 CPU에서 고른 backend (scalar / sha-ni / sse4.1 x4 / avx2 x8 / avx512 x16)
+    // TOYCHAIN_SHA256 환경 변수로 강제할 수 있다 (scalar, shani, sse4, avx2, avx512).
+    static const char *backendName();
+    static size_t laneCount();
+
+private:
+    uint32_t state[8];
+    unsigned char buffer[BLOCK_SIZE];
+    size_t bufferLen;
+    uint64_t totalLen;
+
+    // finishMany 공통 구현. stride가 0이면 모든 메시지가 같은 base / tail을 쓰고, heads가 nullptr이면 head는 비어 있다
+    static void finishLanes(const Sha256 *bases, size_t baseStride, const std::string_view *heads,
+                            const std::string_view *tails, size_t tailStride, size_t count, Hash256 *out);
+};
+
+// 32바이트 해시 값. 내부에서는 바이트 그대로 보관/비교하고 JSON·저장 경계에서만 hex로 변환한다.
+// 모든 바이트가 0인 값은 "부모 없음"(제네시스 previousHash)을 뜻하며 hex로는 "0"으로 표기한다.
+struct Hash256
+{
+    std::array<unsigned char, Sha256::DIGEST_SIZE> bytes{};
+
+    unsigned char *data() { return bytes.data(); }
+    const unsigned char *data() const { return bytes.data(); }
+
+    bool isNull() const;
+    // 앞에서부터 difficulty개의 hex 자릿수(nibble)가 모두 0인지 검사
+    bool meetsDifficulty(int difficulty) const;
+
+    std::string toHex() const;
+    // 64자리 hex 또는 "0"만 허용, 그 외에는 std::invalid_argument
+    static Hash256 fromHex(std::string_view hex);
+
+    bool operator==(const Hash256 &other) const { return bytes == other.bytes; }
+    bool operator!=(const Hash256 &other) const { return bytes != other.bytes; }
+    bool operator<(const Hash256 &other) const { return bytes < other.bytes; }
+};
+
+struct Hash256Hasher
+{
+    size_t operator()(const Hash256 &h) const
+    {
+        // 균일한 SHA-256 출력이므로 8바이트면 충분하다.
+        // 채굴된 블록 해시는 앞쪽이 0이므로 뒤쪽 8바이트를 쓴다.
+        size_t v;
+        std::memcpy(&v, h.data() + Sha256::DIGEST_SIZE - sizeof(v), sizeof(v));
+        return v;
+    }
+};
+
+std::string toHex(const unsigned char *data, size_t len);
+std::string sha256Hex(const std::string &data);
+Hash256 sha256(const std::string &data);
+
+#endif
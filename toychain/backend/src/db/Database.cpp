@@ -1,10 +1,26 @@
 #include "Database.hpp"
 #include "../block.h"
 #include "../utxo.h"
+#include "../chain_store.h"
+#include "../storage.h"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
-#include <sstream>
 #include <filesystem>
 
+namespace
+{
+    void bindHash(sqlite3_stmt *stmt, int col, const Hash256 &h)
+    {
+        sqlite3_bind_blob(stmt, col, h.data(), Sha256::DIGEST_SIZE, SQLITE_STATIC);
+    }
+
+    void bindText(sqlite3_stmt *stmt, int col, const std::string &s)
+    {
+        sqlite3_bind_text(stmt, col, s.data(), static_cast<int>(s.size()), SQLITE_STATIC);
+    }
+}
+
 Database::Database(const std::string &filename)
 {
     try
@@ -24,17 +40,39 @@ Database::Database(const std::string &filename)
     {
         std::cerr << "❌ Cannot open database: " << sqlite3_errmsg(db) << std::endl;
         opened = false;
+        return;
     }
-    else
+
+    // WAL: 커밋이 로그 append 한 번으로 끝나고 reader를 막지 않는다.
+    // 체인 원본은 chain.log이므로 체크포인트마다만 fsync하는 NORMAL로 충분하다.
+    // 해시 키는 무작위라 블록 하나가 인덱스 페이지 대부분을 건드린다: 페이지 캐시와 체크포인트 간격을 넉넉히 둔다.
+    // 쓰는 쪽은 이 클래스뿐이고 항상 부모 행부터 넣으므로 외래 키는 스키마 문서로만 두고 행마다 검사하지 않는다.
+    exec("PRAGMA journal_mode = WAL;");
+    exec("PRAGMA synchronous = NORMAL;");
+    exec("PRAGMA cache_size = -65536;");
+    exec("PRAGMA wal_autocheckpoint = 10000;");
+    exec("PRAGMA foreign_keys = OFF;");
+
+    opened = migrate() &&
+             prepare("INSERT OR REPLACE INTO Block(block_id,height,timestamp,prev_hash,difficulty,nonce) VALUES(?,?,?,?,?,?);", insertBlockStmt) &&
+             prepare("INSERT OR REPLACE INTO Tx(tx_id,block_id) VALUES(?,?);", insertTxStmt) &&
+             prepare("INSERT OR REPLACE INTO TxInput(tx_id,input_index,referenced_tx_id,referenced_output_index,signature) VALUES(?,?,?,?,?);", insertInputStmt) &&
+             prepare("INSERT OR REPLACE INTO TxOutput(tx_id,output_index,address,value) VALUES(?,?,?,?);", insertOutputStmt) &&
+             prepare("DELETE FROM Mempool WHERE tx_id = ?;", deleteMempoolStmt) &&
+             // 이미 있는 트랜잭션은 그대로 둔다 (REPLACE는 rowid를 새로 받아 들어온 순서가 뒤로 밀린다)
+             prepare("INSERT OR IGNORE INTO Mempool(tx_id,raw_data) VALUES(?,?);", insertMempoolStmt);
+    if (opened)
     {
-        opened = true;
         std::cout << "✅ Database connected: " << filename << std::endl;
-        createTables();
     }
 }
 
 Database::~Database()
 {
+    for (sqlite3_stmt *stmt : {insertBlockStmt, insertTxStmt, insertInputStmt, insertOutputStmt, deleteMempoolStmt, insertMempoolStmt})
+    {
+        sqlite3_finalize(stmt); // nullptr이면 아무것도 하지 않는다
+    }
     if (db)
     {
         sqlite3_close(db);
@@ -55,144 +93,299 @@ bool Database::exec(const std::string &sql)
     return true;
 }
 
+bool Database::prepare(const char *sql, sqlite3_stmt *&stmt)
+{
+    if (sqlite3_prepare_v3(db, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK)
+    {
+        std::cerr << "❌ SQL prepare error: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Database::step(sqlite3_stmt *stmt)
+{
+    int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    if (rc != SQLITE_DONE && rc != SQLITE_ROW)
+    {
+        std::cerr << "❌ SQL error: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Database::migrate()
+{
+    int version = 0;
+    sqlite3_stmt *stmt = nullptr;
+    if (prepare("PRAGMA user_version;", stmt) && sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        version = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+
+    if (version > SCHEMA_VERSION)
+    {
+        std::cerr << "❌ Database schema version " << version << " is newer than this node (" << SCHEMA_VERSION << ")\n";
+        return false;
+    }
+    if (version < 1)
+    {
+        // version 0: 해시를 hex TEXT로 저장하던 스키마. 이 DB는 체인에서 다시 만들 수 있는 색인이므로
+        // 테이블을 새로 만들고, 빠진 블록은 시작할 때 체인에서 다시 채운다 (Blockchain::backfillDatabase).
+        bool hadTables = false;
+        if (prepare("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'Block';", stmt))
+        {
+            hadTables = sqlite3_step(stmt) == SQLITE_ROW;
+        }
+        sqlite3_finalize(stmt);
+
+        if (hadTables)
+        {
+            std::cout << "Upgrading database schema to version " << SCHEMA_VERSION << " (tables are rebuilt from the chain)\n";
+            bool ok = exec(R"(
+                BEGIN TRANSACTION;
+                DROP TABLE IF EXISTS TxInput;
+                DROP TABLE IF EXISTS TxOutput;
+                DROP TABLE IF EXISTS Tx;
+                DROP TABLE IF EXISTS Mempool;
+                DROP TABLE IF EXISTS Block;
+                COMMIT;
+            )");
+            if (!ok)
+            {
+                exec("ROLLBACK;");
+                return false;
+            }
+        }
+    }
+    else if (version < 2)
+    {
+        // version 1: Mempool.raw_data에 입력/출력 개수만 있어 복원할 수 없다. 새 형식으로 다시 만든다.
+        if (!exec("DROP TABLE IF EXISTS Mempool;"))
+            return false;
+    }
+
+    createTables();
+    return version == SCHEMA_VERSION || exec("PRAGMA user_version = " + std::to_string(SCHEMA_VERSION) + ";");
+}
+
 void Database::createTables()
 {
-    // based on chain.sql, simplified for UTXO usage
+    // based on chain.sql, simplified for UTXO usage. 해시는 32바이트 BLOB, 기본 키로 바로 정렬되도록 WITHOUT ROWID.
+    // Mempool만 rowid 테이블로 두어 들어온 순서를 유지한다. raw_data는 블록 로그와 같은 트랜잭션 인코딩
     const char *sql = R"(
-        PRAGMA foreign_keys = ON;
         CREATE TABLE IF NOT EXISTS Block(
-            block_id TEXT PRIMARY KEY,
+            block_id BLOB PRIMARY KEY,
             height INTEGER,
             timestamp INTEGER,
-            prev_hash TEXT,
+            prev_hash BLOB,
             difficulty INTEGER,
             nonce INTEGER
-        );
+        ) WITHOUT ROWID;
         CREATE TABLE IF NOT EXISTS Tx(
-            tx_id TEXT PRIMARY KEY,
-            block_id TEXT,
+            tx_id BLOB PRIMARY KEY,
+            block_id BLOB,
             FOREIGN KEY(block_id) REFERENCES Block(block_id) ON DELETE CASCADE
-        );
+        ) WITHOUT ROWID;
         CREATE TABLE IF NOT EXISTS TxOutput(
-            tx_id TEXT,
+            tx_id BLOB,
             output_index INTEGER,
             address TEXT,
             value REAL,
             PRIMARY KEY (tx_id, output_index),
             FOREIGN KEY (tx_id) REFERENCES Tx(tx_id) ON DELETE CASCADE
-        );
+        ) WITHOUT ROWID;
         CREATE TABLE IF NOT EXISTS TxInput(
-            tx_id TEXT,
+            tx_id BLOB,
             input_index INTEGER,
-            referenced_tx_id TEXT,
+            referenced_tx_id BLOB,
             referenced_output_index INTEGER,
             signature TEXT,
             PRIMARY KEY (tx_id, input_index),
             FOREIGN KEY (tx_id) REFERENCES Tx(tx_id) ON DELETE CASCADE
-        );
+        ) WITHOUT ROWID;
         CREATE TABLE IF NOT EXISTS Mempool(
-            tx_id TEXT PRIMARY KEY,
-            raw_data TEXT
+            tx_id BLOB PRIMARY KEY,
+            raw_data BLOB
         );
     )";
 
     exec(sql);
 }
 
-bool Database::insertBlock(const Block &block, const std::vector<UTXOTransaction> &txs)
+bool Database::beginBatch()
 {
-    if (!opened)
+    if (batchDepth++ > 0)
+        return true;
+    batchFailed = false;
+    if (!exec("BEGIN TRANSACTION;"))
+    {
+        batchDepth = 0;
         return false;
+    }
+    return true;
+}
 
-    exec("BEGIN TRANSACTION;");
-
-    std::stringstream bsql;
-    bsql << "INSERT OR REPLACE INTO Block(block_id,height,timestamp,prev_hash,difficulty,nonce) VALUES("
-         << "'" << block.getHash() << "',"
-         << block.getIndex() << ","
-         << block.getTimestamp() << ","
-         << "'" << block.getPreviousHash() << "',"
-         << block.getDifficulty() << ","
-         << block.getNonce() << ");";
-    if (!exec(bsql.str()))
+bool Database::commitBatch()
+{
+    if (batchDepth == 0)
+        return false;
+    if (--batchDepth > 0)
+        return !batchFailed;
+    if (batchFailed)
     {
         exec("ROLLBACK;");
         return false;
     }
+    return exec("COMMIT;");
+}
+
+long long Database::getBlockCount()
+{
+    long long count = -1;
+    sqlite3_stmt *stmt = nullptr;
+    if (prepare("SELECT COALESCE(MAX(height) + 1, 0) FROM Block;", stmt) && sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        count = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return count;
+}
+
+bool Database::insertBlock(const Block &block, const std::vector<UTXOTransaction> &txs)
+{
+    if (!opened || !beginBatch())
+        return false;
+
+    if (!insertBlockRows(block, txs))
+        batchFailed = true;
+    return commitBatch();
+}
+
+bool Database::insertBlockRows(const Block &block, const std::vector<UTXOTransaction> &txs)
+{
+    bindHash(insertBlockStmt, 1, block.getHash());
+    sqlite3_bind_int64(insertBlockStmt, 2, block.getIndex());
+    sqlite3_bind_int64(insertBlockStmt, 3, block.getTimestamp());
+    bindHash(insertBlockStmt, 4, block.getPreviousHash());
+    sqlite3_bind_int(insertBlockStmt, 5, block.getDifficulty());
+    sqlite3_bind_int(insertBlockStmt, 6, block.getNonce());
+    if (!step(insertBlockStmt))
+        return false;
 
+    // 키(tx_id) 순서로, 테이블 하나씩 넣는다. 무작위 해시 순서로 세 인덱스를 번갈아 건드리는 것보다
+    // 같은 B-tree 페이지에 들어갈 행들이 연달아 들어가 페이지 캐시와 WAL 쓰기가 훨씬 적다.
+    std::vector<const UTXOTransaction *> sorted;
+    sorted.reserve(txs.size());
     for (const auto &tx : txs)
+        sorted.push_back(&tx);
+    std::sort(sorted.begin(), sorted.end(), [](const UTXOTransaction *a, const UTXOTransaction *b)
+              { return std::memcmp(a->getId().data(), b->getId().data(), Sha256::DIGEST_SIZE) < 0; });
+
+    for (const UTXOTransaction *tx : sorted)
     {
-        std::stringstream txsql;
-        txsql << "INSERT OR REPLACE INTO Tx(tx_id, block_id) VALUES('"
-              << tx.getId() << "','" << block.getHash() << "');";
-        if (!exec(txsql.str()))
-        {
-            exec("ROLLBACK;");
+        bindHash(insertTxStmt, 1, tx->getId());
+        bindHash(insertTxStmt, 2, block.getHash());
+        if (!step(insertTxStmt))
             return false;
-        }
+    }
 
+    for (const UTXOTransaction *tx : sorted)
+    {
         int inputIdx = 0;
-        for (const auto &in : tx.getInputs())
+        for (const auto &in : tx->getInputs())
         {
-            std::stringstream insql;
-            insql << "INSERT OR REPLACE INTO TxInput(tx_id,input_index,referenced_tx_id,referenced_output_index,signature) VALUES('"
-                  << tx.getId() << "',"
-                  << inputIdx << ",'"
-                  << in.txId << "',"
-                  << in.outputIndex << ",'"
-                  << in.signature << "');";
-            if (!exec(insql.str()))
-            {
-                exec("ROLLBACK;");
+            bindHash(insertInputStmt, 1, tx->getId());
+            sqlite3_bind_int(insertInputStmt, 2, inputIdx++);
+            bindHash(insertInputStmt, 3, in.txId);
+            sqlite3_bind_int(insertInputStmt, 4, in.outputIndex);
+            bindText(insertInputStmt, 5, in.signature);
+            if (!step(insertInputStmt))
                 return false;
-            }
-            inputIdx++;
         }
+    }
 
-        for (size_t outIdx = 0; outIdx < tx.getOutputs().size(); ++outIdx)
+    for (const UTXOTransaction *tx : sorted)
+    {
+        const auto &outs = tx->getOutputs();
+        for (size_t outIdx = 0; outIdx < outs.size(); ++outIdx)
         {
-            const auto &out = tx.getOutputs()[outIdx];
-            std::stringstream outsql;
-            outsql << "INSERT OR REPLACE INTO TxOutput(tx_id,output_index,address,value) VALUES('"
-                   << tx.getId() << "',"
-                   << outIdx << ",'"
-                   << out.address << "',"
-                   << out.amount << ");";
-            if (!exec(outsql.str()))
-            {
-                exec("ROLLBACK;");
+            bindHash(insertOutputStmt, 1, tx->getId());
+            sqlite3_bind_int64(insertOutputStmt, 2, static_cast<sqlite3_int64>(outIdx));
+            bindText(insertOutputStmt, 3, outs[outIdx].address);
+            sqlite3_bind_double(insertOutputStmt, 4, outs[outIdx].amount);
+            if (!step(insertOutputStmt))
                 return false;
-            }
         }
     }
-
-    exec("COMMIT;");
     return true;
 }
 
-bool Database::upsertMempool(const std::vector<UTXOTransaction> &pending)
+bool Database::insertMempool(const std::vector<UTXOTransaction> &added)
 {
-    if (!opened)
+    if (!opened || !beginBatch())
+        return false;
+
+    bool ok = true;
+    std::string raw;
+    for (size_t i = 0; ok && i < added.size(); ++i)
+    {
+        raw.clear();
+        BlockLog::encodeTransaction(added[i], raw);
+        bindHash(insertMempoolStmt, 1, added[i].getId());
+        sqlite3_bind_blob(insertMempoolStmt, 2, raw.data(), static_cast<int>(raw.size()), SQLITE_STATIC);
+        ok = step(insertMempoolStmt);
+    }
+
+    if (!ok)
+        batchFailed = true;
+    return commitBatch();
+}
+
+bool Database::removeMempool(const std::vector<Hash256> &removed)
+{
+    if (!opened || !beginBatch())
         return false;
 
-    exec("BEGIN TRANSACTION;");
-    exec("DELETE FROM Mempool;"); // simple truncate + insert snapshot
+    bool ok = true;
+    for (size_t i = 0; ok && i < removed.size(); ++i)
+    {
+        bindHash(deleteMempoolStmt, 1, removed[i]);
+        ok = step(deleteMempoolStmt);
+    }
+
+    if (!ok)
+        batchFailed = true;
+    return commitBatch();
+}
+
+std::vector<UTXOTransaction> Database::loadMempool()
+{
+    std::vector<UTXOTransaction> pending;
+    if (!opened)
+        return pending;
 
-    for (const auto &tx : pending)
+    sqlite3_stmt *stmt = nullptr;
+    if (!prepare("SELECT raw_data FROM Mempool ORDER BY rowid;", stmt))
+        return pending;
+    while (sqlite3_step(stmt) == SQLITE_ROW)
     {
-        std::stringstream raw;
-        raw << "inputs:" << tx.getInputs().size() << ",outputs:" << tx.getOutputs().size();
-        std::stringstream sql;
-        sql << "INSERT OR REPLACE INTO Mempool(tx_id,raw_data) VALUES('"
-            << tx.getId() << "','"
-            << raw.str() << "');";
-        if (!exec(sql.str()))
+        const unsigned char *raw = static_cast<const unsigned char *>(sqlite3_column_blob(stmt, 0));
+        const size_t len = static_cast<size_t>(sqlite3_column_bytes(stmt, 0));
+        try
         {
-            exec("ROLLBACK;");
-            return false;
+            TxView view(raw, raw + len);
+            if (view.end() != raw + len)
+                throw std::runtime_error("trailing bytes");
+            pending.push_back(view.toTransaction());
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "⚠️ Skipping unreadable mempool row: " << e.what() << "\n";
         }
     }
-
-    exec("COMMIT;");
-    return true;
+    sqlite3_finalize(stmt);
+    return pending;
 }
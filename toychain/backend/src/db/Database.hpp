@@ -14,18 +14,52 @@ private:
     sqlite3 *db;
     bool opened = false;
 
+    // 한 번 준비해서 계속 재사용하는 INSERT 문 (해시는 32바이트 BLOB으로 bind)
+    sqlite3_stmt *insertBlockStmt = nullptr;
+    sqlite3_stmt *insertTxStmt = nullptr;
+    sqlite3_stmt *insertInputStmt = nullptr;
+    sqlite3_stmt *insertOutputStmt = nullptr;
+    sqlite3_stmt *deleteMempoolStmt = nullptr;
+    sqlite3_stmt *insertMempoolStmt = nullptr;
+
+    int batchDepth = 0;   // beginBatch 중첩 수. 0이 될 때 COMMIT
+    bool batchFailed = false;
+
+    bool migrate();
+    bool prepare(const char *sql, sqlite3_stmt *&stmt);
+    bool step(sqlite3_stmt *stmt);
+    bool insertBlockRows(const Block &block, const std::vector<UTXOTransaction> &txs);
+
 public:
+    // 스키마가 바뀔 때마다 올린다 (PRAGMA user_version)
+    static constexpr int SCHEMA_VERSION = 2;
+
     Database(const std::string &filename);
     ~Database();
 
+    Database(const Database &) = delete;
+    Database &operator=(const Database &) = delete;
+
     bool isOpen() const { return opened; }
 
     bool exec(const std::string &sql);
     void createTables();
 
+    // 여러 번의 쓰기를 한 트랜잭션으로 묶는다. 중첩할 수 있고, 안에서 하나라도 실패하면 전체를 ROLLBACK한다.
+    bool beginBatch();
+    bool commitBatch();
+
+    // READ FUNCTIONS
+    // 저장된 블록 높이 + 1 (비어 있으면 0)
+    long long getBlockCount();
+    // 저장된 mempool을 들어온 순서대로 읽는다 (읽을 수 없는 행은 건너뛴다)
+    std::vector<UTXOTransaction> loadMempool();
+
     // WRITE FUNCTIONS
     bool insertBlock(const Block &block, const std::vector<UTXOTransaction> &txs);
-    bool upsertMempool(const std::vector<UTXOTransaction> &pending);
+    // mempool은 바뀐 만큼만 쓴다: 새로 들어온 트랜잭션은 원본 그대로 넣고, 빠진 것은 id로 지운다
+    bool insertMempool(const std::vector<UTXOTransaction> &added);
+    bool removeMempool(const std::vector<Hash256> &removed);
 };
 
 #endif
@@ -0,0 +1,835 @@
+#include "event_loop.h"
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#else
+#include <poll.h>
+#endif
+
+#if defined(__linux__) && defined(SO_REUSEPORT)
+#define TOYCHAIN_REUSEPORT 1
+#endif
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    bool setNonBlocking(int fd, bool on)
+    {
+        int flags = fcntl(fd, F_GETFL, 0);
+        if (flags < 0)
+            return false;
+        flags = on ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+        return fcntl(fd, F_SETFL, flags) == 0;
+    }
+
+    // 연결이 많아도 accept가 EMFILE로 막히지 않도록 열 수 있는 fd 한도를 최대로 올린다
+    void raiseFileLimit()
+    {
+        rlimit limit{};
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+        {
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+        }
+    }
+
+    struct PollEvent
+    {
+        int fd;
+        bool readable; // 읽을 데이터가 있거나 상대가 끊었다 (read가 0/에러를 돌려준다)
+        bool writable;
+        bool hangup; // 읽기 관심을 꺼 두어도 올라온다
+
+    };
+
+    // level-triggered 감시. 쓰기는 보낼 데이터가 남아 있을 때만, 읽기는 입력을 더 받을 수 있을 때만 본다.
+#if defined(__linux__)
+    class Poller
+    {
+    public:
+        ~Poller()
+        {
+            if (epfd >= 0)
+                close(epfd);
+        }
+
+        bool init()
+        {
+            epfd = epoll_create1(EPOLL_CLOEXEC);
+            events.resize(256);
+            return epfd >= 0;
+        }
+
+        bool add(int fd, bool wantRead, bool wantWrite) { return control(EPOLL_CTL_ADD, fd, wantRead, wantWrite); }
+        bool modify(int fd, bool wantRead, bool wantWrite) { return control(EPOLL_CTL_MOD, fd, wantRead, wantWrite); }
+        void remove(int fd) { epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr); }
+
+        void wait(std::vector<PollEvent> &out, int timeoutMs)
+        {
+            out.clear();
+            int n = epoll_wait(epfd, events.data(), (int)events.size(), timeoutMs);
+            for (int i = 0; i < n; ++i)
+            {
+                const uint32_t ev = events[i].events;
+                out.push_back({events[i].data.fd,
+                               (ev & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0,
+                               (ev & EPOLLOUT) != 0,
+                               (ev & (EPOLLHUP | EPOLLERR)) != 0});
+            }
+        }
+
+    private:
+        int epfd = -1;
+        std::vector<epoll_event> events;
+
+        bool control(int op, int fd, bool wantRead, bool wantWrite)
+        {
+            epoll_event ev{};
+            ev.events = (wantRead ? (uint32_t)EPOLLIN : 0u) | (wantWrite ? (uint32_t)EPOLLOUT : 0u);
+            ev.data.fd = fd;
+            return epoll_ctl(epfd, op, fd, &ev) == 0;
+        }
+    };
+#else
+    class Poller
+    {
+    public:
+        bool init() { return true; }
+
+        bool add(int fd, bool wantRead, bool wantWrite)
+        {
+            index[fd] = fds.size();
+            fds.push_back({fd, interest(wantRead, wantWrite), 0});
+            return true;
+        }
+
+        bool modify(int fd, bool wantRead, bool wantWrite)
+        {
+            auto it = index.find(fd);
+            if (it == index.end())
+                return false;
+            fds[it->second].events = interest(wantRead, wantWrite);
+            return true;
+        }
+
+        void remove(int fd)
+        {
+            auto it = index.find(fd);
+            if (it == index.end())
+                return;
+            const size_t pos = it->second;
+            index.erase(it);
+            if (pos + 1 != fds.size())
+            {
+                fds[pos] = fds.back();
+                index[fds[pos].fd] = pos;
+            }
+            fds.pop_back();
+        }
+
+        void wait(std::vector<PollEvent> &out, int timeoutMs)
+        {
+            out.clear();
+            if (::poll(fds.data(), (nfds_t)fds.size(), timeoutMs) <= 0)
+                return;
+            for (const auto &p : fds)
+            {
+                if (p.revents == 0)
+                    continue;
+                out.push_back({p.fd,
+                               (p.revents & (POLLIN | POLLHUP | POLLERR)) != 0,
+                               (p.revents & POLLOUT) != 0,
+                               (p.revents & (POLLHUP | POLLERR)) != 0});
+            }
+        }
+
+    private:
+        std::vector<pollfd> fds;
+        std::unordered_map<int, size_t> index;
+
+        static short interest(bool wantRead, bool wantWrite)
+        {
+            return (short)((wantRead ? POLLIN : 0) | (wantWrite ? POLLOUT : 0));
+        }
+    };
+#endif
+
+    HttpResponse errorResponse(int status)
+    {
+        HttpResponse response;
+        response.status = status;
+        response.body = std::string("{\"error\":\"") + httpStatusReason(status) + "\"}";
+        response.headers.emplace_back("Access-Control-Allow-Origin", "*");
+        return response;
+    }
+
+    const char CONTINUE_RESPONSE[] = "HTTP/1.1 100 Continue\r\n\r\n";
+
+    // SIGINT/SIGTERM을 받으면 켜진다. 루프는 매 대기 뒤에 확인하고 빠져나온다
+    volatile std::sig_atomic_t stopRequested = 0;
+
+    void requestStop(int sig)
+    {
+        stopRequested = 1;
+        // 종료가 멈춘 것처럼 보이면 한 번 더 보내 바로 끝낼 수 있도록
+        std::signal(sig, SIG_DFL);
+    }
+}
+
+class HttpServer::Loop
+{
+public:
+    explicit Loop(HttpServer &server) : server(server) {}
+    ~Loop();
+
+    bool listenOn(int port, bool reusePort);
+    void run();
+
+    // 워커가 만든 응답을 루프로 돌려보낸다 (어느 스레드에서 불러도 된다)
+    void complete(int fd, uint64_t connId, std::string response, HttpBodyStream stream);
+    // WAIT로 멈춘 스트림에 다음 조각을 만들게 한다 (어느 스레드에서 불러도 된다)
+    void wakeStream(int fd, uint64_t connId);
+    // 대기 중인 run을 깨운다 (어느 스레드에서 불러도 된다)
+    void signal();
+
+private:
+    enum class State
+    {
+        READING, // 요청을 받는 중
+        WAITING, // 워커가 응답을 만드는 중
+        WRITING, // 응답을 보내는 중
+    };
+
+    struct Connection
+    {
+        explicit Connection(const HttpLimits &limits) : parser(limits) {}
+
+        uint64_t id = 0; // fd는 재사용되므로 워커 응답은 id로 맞춰 본다
+        State state = State::READING;
+        HttpRequestParser parser;
+        std::string in; // 받았지만 아직 파서에 넘기지 않은 바이트 (파이프라인된 다음 요청들)
+        size_t inOffset = 0;
+        std::string out;
+        size_t outOffset = 0;
+        HttpBodyStream stream; // 아직 본문을 만드는 중인 응답
+        StreamWake wake;       // stream에 넘겨줄 이 연결의 wake
+        bool streamWaiting = false; // stream이 WAIT를 돌려주고 wake를 기다린다
+        bool chunked = true;   // 지금 응답의 본문을 chunked로 보낼 수 있다 (HTTP/1.1 요청)
+        unsigned served = 0;
+        bool closeAfterWrite = false;
+        bool readPaused = false; // 앞 요청의 응답을 기다리는 동안 쌓인 입력이 한도를 넘었거나 상대가 쓰기를 닫았다
+        bool peerClosed = false; // 상대가 쓰기를 닫았다: 받아 둔 요청까지만 응답하고 닫는다
+        Clock::time_point lastActive;
+    };
+
+    struct Completion
+    {
+        int fd;
+        uint64_t connId;
+        std::string response;
+        HttpBodyStream stream;
+    };
+
+    HttpServer &server;
+    Poller poller;
+    int listenFd = -1;
+    int wakeReadFd = -1;
+    int wakeWriteFd = -1;
+    int spareFd = -1; // EMFILE일 때 잠깐 내주고 대기 중인 연결 하나를 받아 닫는 데 쓴다
+    std::unordered_map<int, Connection> connections;
+    uint64_t nextConnId = 1;
+
+    std::mutex completionMtx;
+    std::vector<Completion> completions;
+    std::vector<std::pair<int, uint64_t>> wakes; // 깨울 스트림 (fd, connId)
+
+    Connection *find(int fd);
+    void acceptAll();
+    void onReadable(int fd);
+    void processInput(int fd);
+    void dispatch(int fd, HttpRequest request);
+    void startWrite(int fd, std::string response, bool final);
+    // 직렬화한 응답(stream 응답이면 헤더까지)을 보내기 시작한다
+    void startResponse(int fd, std::string response, HttpBodyStream stream);
+    // out이 빈 뒤 다음 본문 조각을 채운다. 만들다 실패하면 false (연결은 닫힌다)
+    bool produce(Connection &conn);
+    void flush(int fd);
+    void updateInterest(int fd, const Connection &conn);
+    void closeConnection(int fd);
+    void drainWake();
+    void drainCompletions();
+    void sweepIdle();
+};
+
+HttpServer::Loop::~Loop()
+{
+    for (const auto &entry : connections)
+        close(entry.first);
+    for (int fd : {listenFd, wakeReadFd, wakeWriteFd, spareFd})
+    {
+        if (fd >= 0)
+            close(fd);
+    }
+}
+
+bool HttpServer::Loop::listenOn(int port, bool reusePort)
+{
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0)
+    {
+        std::cerr << "❌ socket failed: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    int opt = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+#ifdef TOYCHAIN_REUSEPORT
+    if (reusePort && setsockopt(listenFd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0)
+    {
+        std::cerr << "❌ SO_REUSEPORT failed: " << std::strerror(errno) << "\n";
+        return false;
+    }
+#else
+    (void)reusePort;
+#endif
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(port);
+    if (bind(listenFd, (sockaddr *)&address, sizeof(address)) < 0)
+    {
+        std::cerr << "❌ Bind failed on port " << port << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    if (listen(listenFd, SOMAXCONN) < 0)
+    {
+        std::cerr << "❌ Listen failed: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    setNonBlocking(listenFd, true);
+
+#if defined(__linux__)
+    wakeReadFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    wakeWriteFd = -1;
+    if (wakeReadFd < 0)
+#else
+    int pipeFds[2];
+    if (pipe(pipeFds) == 0)
+    {
+        wakeReadFd = pipeFds[0];
+        wakeWriteFd = pipeFds[1];
+        setNonBlocking(wakeReadFd, true);
+        setNonBlocking(wakeWriteFd, true);
+    }
+    if (wakeReadFd < 0)
+#endif
+    {
+        std::cerr << "❌ Failed to create event loop wake fd: " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    if (!poller.init() || !poller.add(listenFd, true, false) || !poller.add(wakeReadFd, true, false))
+    {
+        std::cerr << "❌ Failed to set up event poller: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    return true;
+}
+
+void HttpServer::Loop::run()
+{
+    std::vector<PollEvent> events;
+    Clock::time_point lastSweep = Clock::now();
+    while (!stopRequested)
+    {
+        poller.wait(events, 1000);
+        for (const auto &ev : events)
+        {
+            if (ev.fd == listenFd)
+            {
+                acceptAll();
+                continue;
+            }
+            if (ev.fd == wakeReadFd)
+            {
+                drainWake();
+                drainCompletions();
+                continue;
+            }
+            // 앞선 이벤트 처리 중에 닫혔을 수 있다
+            if (ev.writable && find(ev.fd))
+            {
+                flush(ev.fd);
+                processInput(ev.fd);
+            }
+            Connection *conn = find(ev.fd);
+            if (conn && ev.hangup && conn->readPaused)
+                closeConnection(ev.fd); // 읽지 않는 동안 연결이 끊겼다
+            else if (ev.readable && conn)
+                onReadable(ev.fd);
+        }
+
+        const auto now = Clock::now();
+        if (now - lastSweep >= std::chrono::seconds(1))
+        {
+            sweepIdle();
+            lastSweep = now;
+        }
+    }
+}
+
+HttpServer::Loop::Connection *HttpServer::Loop::find(int fd)
+{
+    auto it = connections.find(fd);
+    return it == connections.end() ? nullptr : &it->second;
+}
+
+void HttpServer::Loop::acceptAll()
+{
+    while (true)
+    {
+#if defined(__linux__)
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd >= 0)
+            setNonBlocking(fd, true);
+#endif
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            if ((errno == EMFILE || errno == ENFILE) && spareFd >= 0)
+            {
+                // 받지 못한 연결이 큐에 남아 있으면 level-triggered 감시가 계속 깨우므로 하나 받아서 바로 닫는다
+                std::cerr << "⚠️  Too many open files, dropping a connection\n";
+                close(spareFd);
+                int dropped = accept(listenFd, nullptr, nullptr);
+                if (dropped >= 0)
+                    close(dropped);
+                spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                std::cerr << "❌ Accept failed: " << std::strerror(errno) << "\n";
+            return;
+        }
+
+        int opt = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+        if (!poller.add(fd, true, false))
+        {
+            close(fd);
+            continue;
+        }
+        Connection &conn = connections.try_emplace(fd, server.limits).first->second;
+        conn.id = nextConnId++;
+        conn.lastActive = Clock::now();
+    }
+}
+
+void HttpServer::Loop::onReadable(int fd)
+{
+    char buffer[64 * 1024];
+    // 한 연결이 루프를 독점하지 않도록 이벤트 한 번에 몇 번만 읽는다 (남으면 다음 wait에서 다시 깨운다)
+    for (int round = 0; round < 4; ++round)
+    {
+        Connection *conn = find(fd);
+        if (!conn || conn->readPaused)
+            return;
+
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n > 0)
+        {
+            conn->in.append(buffer, (size_t)n);
+            conn->lastActive = Clock::now();
+            processInput(fd);
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+        if (n == 0)
+        {
+            // 쓰기만 닫은 것일 수 있다: 이미 받은 요청에는 응답을 마저 보낸다
+            conn->peerClosed = true;
+            conn->readPaused = true;
+            updateInterest(fd, *conn);
+            processInput(fd);
+            return;
+        }
+        // 에러. 워커가 처리 중이면 그 응답은 completion에서 버려진다
+        closeConnection(fd);
+        return;
+    }
+}
+
+void HttpServer::Loop::processInput(int fd)
+{
+    while (Connection *conn = find(fd))
+    {
+        if (conn->state != State::READING)
+        {
+            // 앞 요청에 응답하는 동안에는 파이프라인된 입력을 쌓아 두기만 하고, 한도를 넘으면 더 읽지 않는다
+            if (!conn->readPaused && conn->in.size() - conn->inOffset > server.limits.maxHeaderBytes)
+            {
+                conn->readPaused = true;
+                updateInterest(fd, *conn);
+            }
+            return;
+        }
+        if (conn->inOffset == conn->in.size())
+        {
+            conn->in.clear();
+            conn->inOffset = 0;
+            if (conn->peerClosed)
+                closeConnection(fd); // 더 올 요청이 없다
+            return;
+        }
+
+        conn->inOffset += conn->parser.feed(conn->in.data() + conn->inOffset, conn->in.size() - conn->inOffset);
+        if (conn->parser.takeContinue())
+        {
+            startWrite(fd, CONTINUE_RESPONSE, false);
+            conn = find(fd);
+            if (!conn)
+                return;
+        }
+
+        if (conn->parser.failed())
+        {
+            // 요청 경계를 잃었으므로 응답하고 닫는다
+            conn->closeAfterWrite = true;
+            startWrite(fd, serializeResponse(errorResponse(conn->parser.errorStatus()), false), true);
+            return;
+        }
+        if (!conn->parser.complete())
+            continue; // 남은 입력을 다 먹었다
+
+        if (conn->inOffset == conn->in.size())
+        {
+            conn->in.clear();
+            conn->inOffset = 0;
+        }
+        dispatch(fd, conn->parser.take());
+    }
+}
+
+void HttpServer::Loop::dispatch(int fd, HttpRequest request)
+{
+    Connection &conn = connections.at(fd);
+    const unsigned maxRequests = server.limits.maxRequestsPerConnection;
+    const bool keepAlive = request.keepAlive && (maxRequests == 0 || conn.served + 1 < maxRequests);
+    conn.closeAfterWrite = !keepAlive;
+    conn.chunked = request.versionMinor >= 1;
+    conn.served++;
+
+    switch (server.routes.classify(request))
+    {
+    case Dispatch::INLINE:
+    {
+        HttpResponse response;
+        try
+        {
+            response = server.routes.handle(request);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "❌ Request " << request.method << " " << request.target << " failed: " << e.what() << "\n";
+            response = errorResponse(500);
+        }
+        std::string bytes = serializeResponse(response, keepAlive, conn.chunked);
+        startResponse(fd, std::move(bytes), std::move(response.stream));
+        return;
+    }
+    case Dispatch::WORKER:
+    {
+        conn.state = State::WAITING;
+        const uint64_t connId = conn.id;
+        const bool chunked = conn.chunked;
+        server.pool.submit([this, fd, connId, keepAlive, chunked, request = std::move(request)]()
+                           {
+            HttpResponse response;
+            try
+            {
+                response = server.routes.handle(request);
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "❌ Request " << request.method << " " << request.target << " failed: " << e.what() << "\n";
+                response = errorResponse(500);
+            }
+            std::string bytes = serializeResponse(response, keepAlive, chunked);
+            complete(fd, connId, std::move(bytes), std::move(response.stream)); });
+        return;
+    }
+    }
+}
+
+void HttpServer::Loop::startWrite(int fd, std::string response, bool final)
+{
+    Connection &conn = connections.at(fd);
+    if (final)
+        conn.state = State::WRITING;
+    conn.out += response;
+    flush(fd);
+}
+
+void HttpServer::Loop::startResponse(int fd, std::string response, HttpBodyStream stream)
+{
+    Connection &conn = connections.at(fd);
+    if (stream)
+    {
+        conn.stream = std::move(stream);
+        conn.streamWaiting = false;
+        if (!conn.wake)
+        {
+            const uint64_t connId = conn.id;
+            conn.wake = [this, fd, connId]()
+            { wakeStream(fd, connId); };
+        }
+        if (!conn.chunked)
+            conn.closeAfterWrite = true; // HTTP/1.0: 닫아서 본문의 끝을 알린다
+    }
+    startWrite(fd, std::move(response), true);
+}
+
+bool HttpServer::Loop::produce(Connection &conn)
+{
+    // out은 비어 있다 (앞 조각을 다 보냈다). 용량은 남아 있으므로 조각을 그 자리에 바로 만든다
+    const size_t chunkStart = conn.chunked ? beginChunk(conn.out) : 0;
+    StreamStatus status;
+    try
+    {
+        status = conn.stream(conn.out, conn.wake);
+    }
+    catch (const std::exception &e)
+    {
+        // 상태줄은 이미 나갔으므로 끝 표시 없이 닫아 잘린 응답임을 알린다
+        std::cerr << "❌ Streaming response failed: " << e.what() << "\n";
+        conn.out.clear();
+        conn.stream = nullptr;
+        conn.closeAfterWrite = true;
+        return false;
+    }
+
+    if (conn.chunked)
+    {
+        endChunk(conn.out, chunkStart);
+        if (status == StreamStatus::DONE)
+            appendLastChunk(conn.out);
+    }
+    if (status == StreamStatus::DONE)
+        conn.stream = nullptr;
+    conn.streamWaiting = status == StreamStatus::WAIT;
+    return true;
+}
+
+void HttpServer::Loop::flush(int fd)
+{
+    Connection &conn = connections.at(fd);
+    while (true)
+    {
+        while (conn.outOffset < conn.out.size())
+        {
+            ssize_t n = send(fd, conn.out.data() + conn.outOffset, conn.out.size() - conn.outOffset, 0);
+            if (n > 0)
+            {
+                conn.outOffset += (size_t)n;
+                conn.lastActive = Clock::now();
+                continue;
+            }
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                updateInterest(fd, conn);
+                return;
+            }
+            closeConnection(fd);
+            return;
+        }
+
+        conn.out.clear();
+        conn.outOffset = 0;
+        // 만들어 가며 보내는 본문: 앞 조각이 다 나가야 다음 조각을 만든다
+        if (conn.stream && conn.streamWaiting)
+        {
+            updateInterest(fd, conn); // 다음 조각은 wake가 오면 만든다
+            return;
+        }
+        if (!conn.stream || !produce(conn))
+            break;
+    }
+
+    if (conn.state == State::WRITING)
+    {
+        // 응답 하나를 다 보냈다: 닫거나 다음 요청을 받는다 (이미 받아 둔 입력은 호출한 쪽이 processInput으로 넘긴다)
+        if (conn.closeAfterWrite)
+        {
+            closeConnection(fd);
+            return;
+        }
+        conn.state = State::READING;
+        conn.readPaused = conn.peerClosed;
+    }
+    updateInterest(fd, conn);
+}
+
+void HttpServer::Loop::updateInterest(int fd, const Connection &conn)
+{
+    poller.modify(fd, !conn.readPaused, conn.outOffset < conn.out.size());
+}
+
+void HttpServer::Loop::closeConnection(int fd)
+{
+    poller.remove(fd);
+    connections.erase(fd);
+    close(fd);
+}
+
+void HttpServer::Loop::complete(int fd, uint64_t connId, std::string response, HttpBodyStream stream)
+{
+    {
+        std::lock_guard<std::mutex> lock(completionMtx);
+        completions.push_back({fd, connId, std::move(response), std::move(stream)});
+    }
+    signal();
+}
+
+void HttpServer::Loop::wakeStream(int fd, uint64_t connId)
+{
+    {
+        std::lock_guard<std::mutex> lock(completionMtx);
+        wakes.emplace_back(fd, connId);
+    }
+    signal();
+}
+
+void HttpServer::Loop::signal()
+{
+#if defined(__linux__)
+    uint64_t one = 1;
+    ssize_t ignored = write(wakeReadFd, &one, sizeof(one));
+#else
+    char one = 1;
+    ssize_t ignored = write(wakeWriteFd, &one, 1);
+#endif
+    (void)ignored;
+}
+
+void HttpServer::Loop::drainWake()
+{
+    char buffer[64];
+    while (read(wakeReadFd, buffer, sizeof(buffer)) > 0)
+    {
+    }
+}
+
+void HttpServer::Loop::drainCompletions()
+{
+    std::vector<Completion> ready;
+    std::vector<std::pair<int, uint64_t>> woken;
+    {
+        std::lock_guard<std::mutex> lock(completionMtx);
+        ready.swap(completions);
+        woken.swap(wakes);
+    }
+    for (auto &c : ready)
+    {
+        Connection *conn = find(c.fd);
+        // 기다리는 동안 클라이언트가 끊었으면 (fd가 다른 연결에 재사용됐을 수도 있다) 버린다
+        if (!conn || conn->id != c.connId || conn->state != State::WAITING)
+            continue;
+        startResponse(c.fd, std::move(c.response), std::move(c.stream));
+        // 응답을 기다리는 동안 쌓인 파이프라인 요청을 이어서 처리한다
+        processInput(c.fd);
+    }
+    for (const auto &[fd, connId] : woken)
+    {
+        Connection *conn = find(fd);
+        // 이미 끝났거나 닫힌 스트림, 또는 아직 앞 조각을 보내는 중인 스트림(다 보내면 어차피 다시 묻는다)
+        if (!conn || conn->id != connId || !conn->stream || !conn->streamWaiting)
+            continue;
+        conn->streamWaiting = false;
+        flush(fd);
+        processInput(fd);
+    }
+}
+
+void HttpServer::Loop::sweepIdle()
+{
+    const auto deadline = Clock::now() - std::chrono::seconds(server.limits.idleTimeoutSeconds);
+    std::vector<int> idle;
+    for (const auto &[fd, conn] : connections)
+    {
+        // 워커 응답이나 보낼 이벤트를 기다리는 연결은 조용해도 닫지 않는다
+        if (conn.state != State::WAITING && !conn.streamWaiting && conn.lastActive < deadline)
+            idle.push_back(fd);
+    }
+    for (int fd : idle)
+        closeConnection(fd);
+}
+
+HttpServer::HttpServer(Routes routes, WorkerPool &pool, HttpLimits limits)
+    : routes(std::move(routes)), pool(pool), limits(limits)
+{
+}
+
+HttpServer::~HttpServer() = default;
+
+bool HttpServer::run(int port, unsigned count)
+{
+#ifndef TOYCHAIN_REUSEPORT
+    count = 1; // 커널이 연결을 나눠 주지 않으면 루프를 여러 개 둘 이유가 없다
+#endif
+    if (count == 0)
+        count = 1;
+
+    // 끊긴 소켓에 쓰면 프로세스가 죽지 않고 EPIPE를 받도록
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+    raiseFileLimit();
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        auto loop = std::make_unique<Loop>(*this);
+        if (!loop->listenOn(port, count > 1))
+            return false;
+        loops.push_back(std::move(loop));
+    }
+
+    std::cout << "Server listening on port " << port << " (" << count << " event loop"
+              << (count > 1 ? "s" : "") << ", " << pool.size() << " workers)...\n";
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < count; ++i)
+        threads.emplace_back(&Loop::run, loops[i].get());
+    loops[0]->run();
+    // 시그널을 받은 스레드 말고는 대기 시간이 끝나야 알아채므로 바로 깨운다
+    for (unsigned i = 1; i < count; ++i)
+        loops[i]->signal();
+    for (auto &t : threads)
+        t.join();
+    std::cout << "Server stopped.\n";
+    return true;
+}
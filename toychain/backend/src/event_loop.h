@@ -0,0 +1,57 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include "http_parser.h"
+#include "worker_pool.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 논블로킹 HTTP/1.1 이벤트 루프.
+//
+// 루프(스레드)마다 같은 포트에 SO_REUSEPORT 리스닝 소켓을 따로 열어 커널이 새 연결을 나눠 준다.
+// 루프는 accept / read / 요청 파싱 / write만 하고, 요청 처리는 Routes::classify가 고른 곳에서 한다:
+//   INLINE - 루프 스레드에서 바로 (짧은 조회)
+//   WORKER - WorkerPool에서 처리하고 응답만 루프로 돌려받는다 (채굴, 블록 검증, 피어 전파)
+// 연결은 keep-alive로 유지되고, 파이프라인된 요청은 받은 순서대로 하나씩 처리해 응답 순서를 지킨다.
+// HttpResponse::stream이 있는 응답은 루프가 앞 조각을 다 보낸 뒤에 다음 조각을 만들어 chunked로 보내므로,
+// 본문이 아무리 커도 연결마다 조각 하나만큼만 버퍼에 둔다. 스트림이 WAIT를 돌려주면 (SSE처럼 보낼 것이 생길 때까지
+// 붙잡아 두는 응답) 스레드를 쓰지 않고 연결만 남겨 두었다가, 다른 스레드가 wake를 부르면 루프가 다음 조각을 만든다.
+// Linux는 epoll, 그 밖의 플랫폼은 poll을 쓰고 루프 하나만 돌린다.
+class HttpServer
+{
+public:
+    enum class Dispatch
+    {
+        INLINE,
+        WORKER,
+    };
+
+    struct Routes
+    {
+        std::function<Dispatch(const HttpRequest &request)> classify;
+        std::function<HttpResponse(const HttpRequest &request)> handle;
+    };
+
+    HttpServer(Routes routes, WorkerPool &pool, HttpLimits limits = HttpLimits());
+    ~HttpServer();
+
+    HttpServer(const HttpServer &) = delete;
+    HttpServer &operator=(const HttpServer &) = delete;
+
+    // loops개의 이벤트 루프로 port를 서비스한다. 리스닝에 실패하면 false,
+    // SIGINT/SIGTERM을 받으면 루프를 모두 멈추고 true를 돌려준다.
+    // 워커 작업과 스트림 wake가 루프를 가리키므로 루프와 연결은 소멸자에서 정리한다. pool을 먼저 비운 뒤 소멸시킬 것
+    bool run(int port, unsigned loops);
+
+private:
+    class Loop;
+
+    Routes routes;
+    WorkerPool &pool;
+    HttpLimits limits;
+    std::vector<std::unique_ptr<Loop>> loops;
+};
+
+#endif
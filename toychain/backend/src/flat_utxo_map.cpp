@@ -0,0 +1,190 @@
+#include "flat_utxo_map.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // control byte: 0..127 = 사용 중(해시 하위 7비트), 음수 = 비어 있음/삭제됨
+    constexpr int8_t CTRL_EMPTY = -128;
+    constexpr int8_t CTRL_DELETED = -2;
+    constexpr size_t NPOS = static_cast<size_t>(-1);
+
+    inline size_t hashOf(const OutPoint &key) { return OutPointHasher()(key); }
+    inline size_t h1(size_t hash) { return hash >> 7; }
+    inline int8_t h2(size_t hash) { return static_cast<int8_t>(hash & 0x7F); }
+
+    inline int lowestBit(uint32_t mask) { return __builtin_ctz(mask); }
+
+    inline size_t maxLoad(size_t capacity) { return capacity - capacity / 8; }
+
+#if defined(__SSE2__)
+    inline uint32_t matchByte(const int8_t *group, int8_t value)
+    {
+        __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(value))));
+    }
+
+    // 비어 있거나 삭제된 슬롯 = 최상위 비트가 선 control byte
+    inline uint32_t matchAvailable(const int8_t *group)
+    {
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(group))));
+    }
+#else
+    inline uint32_t matchByte(const int8_t *group, int8_t value)
+    {
+        uint32_t mask = 0;
+        for (size_t i = 0; i < FlatUTXOMap::GROUP_SIZE; ++i)
+            mask |= static_cast<uint32_t>(group[i] == value) << i;
+        return mask;
+    }
+
+    inline uint32_t matchAvailable(const int8_t *group)
+    {
+        uint32_t mask = 0;
+        for (size_t i = 0; i < FlatUTXOMap::GROUP_SIZE; ++i)
+            mask |= static_cast<uint32_t>(group[i] < 0) << i;
+        return mask;
+    }
+#endif
+}
+
+size_t FlatUTXOMap::findIndex(const OutPoint &key, size_t hash) const
+{
+    if (ctrl.empty())
+        return NPOS;
+
+    const size_t groupMask = ctrl.size() / GROUP_SIZE - 1;
+    const int8_t tag = h2(hash);
+    size_t group = h1(hash) & groupMask;
+
+    for (size_t step = 1; step <= groupMask + 1; ++step)
+    {
+        const size_t base = group * GROUP_SIZE;
+        for (uint32_t m = matchByte(&ctrl[base], tag); m != 0; m &= m - 1)
+        {
+            size_t idx = base + lowestBit(m);
+            if (slots[idx].outPoint == key)
+                return idx;
+        }
+        // 빈 슬롯이 있는 group에서 probe는 끝난다
+        if (matchByte(&ctrl[base], CTRL_EMPTY) != 0)
+            return NPOS;
+        group = (group + step) & groupMask;
+    }
+    return NPOS;
+}
+
+size_t FlatUTXOMap::findInsertSlot(size_t hash) const
+{
+    const size_t groupMask = ctrl.size() / GROUP_SIZE - 1;
+    size_t group = h1(hash) & groupMask;
+
+    for (size_t step = 1;; ++step)
+    {
+        const size_t base = group * GROUP_SIZE;
+        uint32_t m = matchAvailable(&ctrl[base]);
+        if (m != 0)
+            return base + lowestBit(m);
+        group = (group + step) & groupMask;
+    }
+}
+
+UTXORecord *FlatUTXOMap::find(const OutPoint &key)
+{
+    size_t idx = findIndex(key, hashOf(key));
+    return idx == NPOS ? nullptr : &slots[idx];
+}
+
+const UTXORecord *FlatUTXOMap::find(const OutPoint &key) const
+{
+    size_t idx = findIndex(key, hashOf(key));
+    return idx == NPOS ? nullptr : &slots[idx];
+}
+
+std::pair<UTXORecord *, bool> FlatUTXOMap::insert(const OutPoint &key)
+{
+    const size_t hash = hashOf(key);
+    size_t idx = findIndex(key, hash);
+    if (idx != NPOS)
+        return {&slots[idx], false};
+
+    if (growthLeft == 0)
+    {
+        // tombstone이 대부분이면 같은 크기로 정리만 하고, 실제로 찼으면 두 배로 키운다
+        size_t cap = ctrl.size();
+        if (cap == 0)
+            rehash(GROUP_SIZE);
+        else if (count * 32 <= cap * 25)
+            rehash(cap);
+        else
+            rehash(cap * 2);
+    }
+
+    idx = findInsertSlot(hash);
+    if (ctrl[idx] == CTRL_EMPTY)
+        --growthLeft;
+    ctrl[idx] = h2(hash);
+    slots[idx] = UTXORecord{key, 0, 0, 0.0};
+    ++count;
+    return {&slots[idx], true};
+}
+
+bool FlatUTXOMap::erase(const OutPoint &key)
+{
+    size_t idx = findIndex(key, hashOf(key));
+    if (idx == NPOS)
+        return false;
+
+    // group에 빈 슬롯이 이미 있으면 이 group을 지나쳐 간 probe가 없으므로 바로 비워도 된다.
+    // 그렇지 않으면 뒤쪽 key를 찾을 수 있도록 tombstone을 남긴다.
+    const size_t base = idx & ~(GROUP_SIZE - 1);
+    if (matchByte(&ctrl[base], CTRL_EMPTY) != 0)
+    {
+        ctrl[idx] = CTRL_EMPTY;
+        ++growthLeft;
+    }
+    else
+    {
+        ctrl[idx] = CTRL_DELETED;
+    }
+    --count;
+    return true;
+}
+
+void FlatUTXOMap::reserve(size_t wanted)
+{
+    size_t cap = GROUP_SIZE;
+    while (maxLoad(cap) < wanted)
+        cap *= 2;
+    if (cap > ctrl.size())
+        rehash(cap);
+}
+
+void FlatUTXOMap::clear()
+{
+    ctrl.clear();
+    slots.clear();
+    count = 0;
+    growthLeft = 0;
+}
+
+void FlatUTXOMap::rehash(size_t newCapacity)
+{
+    std::vector<int8_t> oldCtrl(newCapacity, CTRL_EMPTY);
+    std::vector<UTXORecord> oldSlots(newCapacity);
+    oldCtrl.swap(ctrl);
+    oldSlots.swap(slots);
+
+    for (size_t i = 0; i < oldCtrl.size(); ++i)
+    {
+        if (oldCtrl[i] < 0)
+            continue;
+        const size_t hash = hashOf(oldSlots[i].outPoint);
+        size_t idx = findInsertSlot(hash);
+        ctrl[idx] = h2(hash);
+        slots[idx] = oldSlots[i];
+    }
+    growthLeft = maxLoad(newCapacity) - count;
+}
@@ -0,0 +1,67 @@
+#ifndef FLAT_UTXO_MAP_H
+#define FLAT_UTXO_MAP_H
+
+#include "outpoint.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// UTXOSet 내부에 저장되는 output 한 개. 주소 문자열 대신 intern된 주소 id만 들고 있다.
+struct UTXORecord
+{
+    OutPoint outPoint;
+    uint32_t addressId;
+    uint32_t addressSlot; // UTXOSet의 주소별 outpoint 목록 안에서의 위치
+    double amount;
+};
+
+// outpoint → UTXORecord 전용 open-addressing 해시 테이블 (Swiss table 방식)
+// - 레코드를 노드 할당 없이 연속 배열에 그대로 저장한다.
+// - 슬롯마다 1바이트 control byte(비었음/삭제됨/해시 하위 7비트)를 두고,
+//   16개씩 묶은 group을 SSE2 비교 한 번으로 훑어 후보 슬롯만 실제 key와 비교한다.
+// - group 단위 triangular probing, 최대 load factor 7/8.
+// 반환된 포인터는 다음 insert/erase/reserve 전까지만 유효하다.
+class FlatUTXOMap
+{
+public:
+    static constexpr size_t GROUP_SIZE = 16;
+
+    FlatUTXOMap() = default;
+
+    UTXORecord *find(const OutPoint &key);
+    const UTXORecord *find(const OutPoint &key) const;
+    // key가 없으면 outPoint만 채운 레코드를 새로 만든다. second는 새로 만들었는지 여부
+    std::pair<UTXORecord *, bool> insert(const OutPoint &key);
+    bool erase(const OutPoint &key);
+
+    void reserve(size_t count);
+    void clear();
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t capacity() const { return ctrl.size(); }
+    // 슬롯 배열 + control byte가 차지하는 바이트 수
+    size_t memoryUsage() const { return ctrl.capacity() + slots.capacity() * sizeof(UTXORecord); }
+
+    template <typename Fn>
+    void forEach(Fn &&fn) const
+    {
+        for (size_t i = 0; i < ctrl.size(); ++i)
+        {
+            if (ctrl[i] >= 0)
+                fn(slots[i]);
+        }
+    }
+
+private:
+    std::vector<int8_t> ctrl;       // capacity개, 항상 GROUP_SIZE의 2의 거듭제곱 배
+    std::vector<UTXORecord> slots;  // capacity개
+    size_t count = 0;
+    size_t growthLeft = 0;          // rehash 없이 더 채울 수 있는 빈 슬롯 수 (tombstone 제외)
+
+    size_t findIndex(const OutPoint &key, size_t hash) const;
+    size_t findInsertSlot(size_t hash) const;
+    void rehash(size_t newCapacity);
+};
+
+#endif
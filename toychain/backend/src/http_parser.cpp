@@ -0,0 +1,435 @@
+#include "http_parser.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace
+{
+    // 청크 크기 줄(확장 포함)이 이보다 길면 거절한다
+    constexpr size_t MAX_CHUNK_LINE = 1024;
+    // 본문이 오기 전에 Content-Length만 보고 미리 잡아 두는 최대 크기. 나머지는 실제로 받으면서 늘린다
+    constexpr size_t MAX_BODY_RESERVE = 64 * 1024;
+
+    std::string toLower(std::string s)
+    {
+        for (auto &c : s)
+            c = (char)std::tolower((unsigned char)c);
+        return s;
+    }
+
+    std::string trim(const std::string &s)
+    {
+        size_t begin = s.find_first_not_of(" \t");
+        if (begin == std::string::npos)
+            return "";
+        size_t end = s.find_last_not_of(" \t");
+        return s.substr(begin, end - begin + 1);
+    }
+
+    // 쉼표로 나눈 토큰 목록 (Connection, Transfer-Encoding)
+    std::vector<std::string> tokens(const std::string &value)
+    {
+        std::vector<std::string> out;
+        size_t start = 0;
+        while (start <= value.size())
+        {
+            size_t comma = value.find(',', start);
+            if (comma == std::string::npos)
+                comma = value.size();
+            std::string token = toLower(trim(value.substr(start, comma - start)));
+            if (!token.empty())
+                out.push_back(std::move(token));
+            start = comma + 1;
+        }
+        return out;
+    }
+
+    bool isTokenChar(char c)
+    {
+        return std::isalnum((unsigned char)c) || std::strchr("!#$%&'*+-.^_`|~", c) != nullptr;
+    }
+}
+
+const std::string *HttpRequest::header(const std::string &lowerName) const
+{
+    for (const auto &[name, value] : headers)
+    {
+        if (name == lowerName)
+            return &value;
+    }
+    return nullptr;
+}
+
+std::string HttpRequest::path() const
+{
+    return target.substr(0, target.find('?'));
+}
+
+const char *httpStatusReason(int status)
+{
+    switch (status)
+    {
+    case 100:
+        return "Continue";
+    case 200:
+        return "OK";
+    case 400:
+        return "Bad Request";
+    case 404:
+        return "Not Found";
+    case 413:
+        return "Payload Too Large";
+    case 414:
+        return "URI Too Long";
+    case 431:
+        return "Request Header Fields Too Large";
+    case 500:
+        return "Internal Server Error";
+    case 501:
+        return "Not Implemented";
+    case 505:
+        return "HTTP Version Not Supported";
+    default:
+        return "Unknown";
+    }
+}
+
+std::string serializeResponse(const HttpResponse &response, bool keepAlive, bool chunked)
+{
+    std::string out;
+    out.reserve(256 + response.body.size());
+    out += "HTTP/1.1 " + std::to_string(response.status) + " " + httpStatusReason(response.status) + "\r\n";
+    out += "Content-Type: " + response.contentType + "\r\n";
+    if (!response.stream)
+        out += "Content-Length: " + std::to_string(response.body.size()) + "\r\n";
+    else if (chunked)
+        out += "Transfer-Encoding: chunked\r\n";
+    else
+        keepAlive = false; // 길이를 모르므로 연결을 닫아 본문의 끝을 알린다
+    out += keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+    for (const auto &[name, value] : response.headers)
+        out += name + ": " + value + "\r\n";
+    out += "\r\n";
+    if (!response.stream)
+        out += response.body;
+    return out;
+}
+
+namespace
+{
+    // 크기 자리: 8자리 hex + CRLF. 앞자리 0은 chunk-size 문법상 허용된다
+    constexpr size_t CHUNK_SIZE_DIGITS = 8;
+}
+
+size_t beginChunk(std::string &out)
+{
+    const size_t chunkStart = out.size();
+    out.append(CHUNK_SIZE_DIGITS, '0');
+    out += "\r\n";
+    return chunkStart;
+}
+
+void endChunk(std::string &out, size_t chunkStart)
+{
+    const size_t dataStart = chunkStart + CHUNK_SIZE_DIGITS + 2;
+    size_t size = out.size() - dataStart;
+    if (size == 0)
+    {
+        out.resize(chunkStart); // 빈 조각은 끝 표시로 읽히므로 보내지 않는다
+        return;
+    }
+    static const char HEX[] = "0123456789abcdef";
+    for (size_t i = CHUNK_SIZE_DIGITS; i-- > 0; size >>= 4)
+        out[chunkStart + i] = HEX[size & 0x0f];
+    out += "\r\n";
+}
+
+void appendLastChunk(std::string &out)
+{
+    out += "0\r\n\r\n";
+}
+
+HttpRequestParser::HttpRequestParser(const HttpLimits &limits) : limits(limits)
+{
+}
+
+void HttpRequestParser::reset()
+{
+    state = State::REQUEST_LINE;
+    request = HttpRequest();
+    line.clear();
+    headerBytes = 0;
+    remaining = 0;
+    continuePending = false;
+    error = 0;
+}
+
+HttpRequest HttpRequestParser::take()
+{
+    HttpRequest out = std::move(request);
+    reset();
+    return out;
+}
+
+bool HttpRequestParser::takeContinue()
+{
+    bool pending = continuePending;
+    continuePending = false;
+    return pending;
+}
+
+void HttpRequestParser::fail(int status)
+{
+    state = State::FAILED;
+    error = status;
+    continuePending = false;
+}
+
+size_t HttpRequestParser::feed(const char *data, size_t len)
+{
+    size_t pos = 0;
+    while (pos < len && state != State::COMPLETE && state != State::FAILED)
+    {
+        if (state == State::BODY || state == State::CHUNK_DATA)
+        {
+            size_t take = std::min(remaining, len - pos);
+            request.body.append(data + pos, take);
+            pos += take;
+            remaining -= take;
+            if (remaining == 0)
+                state = state == State::BODY ? State::COMPLETE : State::CHUNK_END;
+            continue;
+        }
+
+        // 나머지 상태는 줄 단위
+        const char *nl = (const char *)std::memchr(data + pos, '\n', len - pos);
+        size_t take = nl ? (size_t)(nl - (data + pos)) + 1 : len - pos;
+        line.append(data + pos, take);
+        pos += take;
+
+        if (state == State::CHUNK_SIZE || state == State::CHUNK_END)
+        {
+            if (line.size() > MAX_CHUNK_LINE)
+            {
+                fail(400);
+                break;
+            }
+        }
+        else
+        {
+            headerBytes += take;
+            if (headerBytes > limits.maxHeaderBytes)
+            {
+                fail(state == State::REQUEST_LINE ? 414 : 431);
+                break;
+            }
+        }
+
+        if (!nl)
+            break;
+        line.pop_back();
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        onLine();
+        line.clear();
+    }
+    return pos;
+}
+
+void HttpRequestParser::onLine()
+{
+    switch (state)
+    {
+    case State::REQUEST_LINE:
+        // 요청 사이의 빈 줄은 건너뛴다 (RFC 9112 2.2)
+        if (line.empty())
+            return;
+        parseRequestLine();
+        return;
+    case State::HEADERS:
+        if (line.empty())
+            finishHeaders();
+        else
+            parseHeaderLine();
+        return;
+    case State::CHUNK_SIZE:
+        parseChunkSize();
+        return;
+    case State::CHUNK_END:
+        if (!line.empty())
+            fail(400);
+        else
+            state = State::CHUNK_SIZE;
+        return;
+    case State::TRAILERS:
+        // trailer 필드는 쓰지 않으므로 크기만 세고 버린다
+        if (line.empty())
+            state = State::COMPLETE;
+        return;
+    default:
+        return;
+    }
+}
+
+void HttpRequestParser::parseRequestLine()
+{
+    // METHOD SP request-target SP HTTP-version
+    size_t sp1 = line.find(' ');
+    size_t sp2 = sp1 == std::string::npos ? std::string::npos : line.find(' ', sp1 + 1);
+    if (sp1 == 0 || sp1 == std::string::npos || sp2 == std::string::npos || sp2 == sp1 + 1 ||
+        line.find(' ', sp2 + 1) != std::string::npos)
+    {
+        fail(400);
+        return;
+    }
+
+    request.method = line.substr(0, sp1);
+    if (!std::all_of(request.method.begin(), request.method.end(), isTokenChar))
+    {
+        fail(400);
+        return;
+    }
+    request.target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+
+    const std::string version = line.substr(sp2 + 1);
+    if (version.size() != 8 || version.compare(0, 5, "HTTP/") != 0 || version[6] != '.' ||
+        !std::isdigit((unsigned char)version[5]) || !std::isdigit((unsigned char)version[7]))
+    {
+        fail(400);
+        return;
+    }
+    if (version[5] != '1')
+    {
+        fail(505);
+        return;
+    }
+    request.versionMinor = version[7] - '0';
+    state = State::HEADERS;
+}
+
+void HttpRequestParser::parseHeaderLine()
+{
+    // obs-fold(줄 앞 공백으로 이어 쓰기)는 받지 않는다
+    if (line[0] == ' ' || line[0] == '\t')
+    {
+        fail(400);
+        return;
+    }
+    size_t colon = line.find(':');
+    if (colon == 0 || colon == std::string::npos ||
+        !std::all_of(line.begin(), line.begin() + colon, isTokenChar))
+    {
+        fail(400);
+        return;
+    }
+    if (request.headers.size() >= limits.maxHeaders)
+    {
+        fail(431);
+        return;
+    }
+    request.headers.emplace_back(toLower(line.substr(0, colon)), trim(line.substr(colon + 1)));
+}
+
+void HttpRequestParser::finishHeaders()
+{
+    // 연결 유지: 1.1은 기본 유지, 1.0은 keep-alive를 요청해야 유지
+    bool close = false;
+    bool keepAlive = false;
+    for (const auto &[name, value] : request.headers)
+    {
+        if (name != "connection")
+            continue;
+        for (const auto &token : tokens(value))
+        {
+            close = close || token == "close";
+            keepAlive = keepAlive || token == "keep-alive";
+        }
+    }
+    request.keepAlive = request.versionMinor >= 1 ? !close : (keepAlive && !close);
+
+    // 본문 길이. Transfer-Encoding과 Content-Length가 같이 오면 요청 밀반입을 막기 위해 거절한다
+    const std::string *transferEncoding = request.header("transfer-encoding");
+    const std::string *contentLength = nullptr;
+    for (const auto &[name, value] : request.headers)
+    {
+        if (name != "content-length")
+            continue;
+        if (contentLength && *contentLength != value)
+        {
+            fail(400);
+            return;
+        }
+        contentLength = &value;
+    }
+
+    if (transferEncoding)
+    {
+        if (contentLength || request.versionMinor == 0)
+        {
+            fail(400);
+            return;
+        }
+        auto codings = tokens(*transferEncoding);
+        if (codings.size() != 1 || codings[0] != "chunked")
+        {
+            fail(501); // chunked 외의 인코딩은 지원하지 않는다
+            return;
+        }
+        state = State::CHUNK_SIZE;
+    }
+    else if (contentLength)
+    {
+        if (contentLength->empty() || contentLength->size() > 19 ||
+            !std::all_of(contentLength->begin(), contentLength->end(), [](char c)
+                         { return std::isdigit((unsigned char)c); }))
+        {
+            fail(400);
+            return;
+        }
+        remaining = std::stoull(*contentLength);
+        if (remaining > limits.maxBodyBytes)
+        {
+            fail(413);
+            return;
+        }
+        request.body.reserve(std::min(remaining, MAX_BODY_RESERVE));
+        state = remaining > 0 ? State::BODY : State::COMPLETE;
+    }
+    else
+    {
+        state = State::COMPLETE;
+    }
+
+    if (state != State::COMPLETE && request.versionMinor >= 1)
+    {
+        const std::string *expect = request.header("expect");
+        continuePending = expect && toLower(*expect) == "100-continue";
+    }
+}
+
+void HttpRequestParser::parseChunkSize()
+{
+    // chunk-size [; chunk-ext]
+    size_t end = line.find_first_of("; \t");
+    std::string hex = line.substr(0, end);
+    if (hex.empty() || hex.size() > 15 ||
+        !std::all_of(hex.begin(), hex.end(), [](char c)
+                     { return std::isxdigit((unsigned char)c); }))
+    {
+        fail(400);
+        return;
+    }
+    size_t size = std::stoull(hex, nullptr, 16);
+    if (size == 0)
+    {
+        state = State::TRAILERS;
+        return;
+    }
+    if (request.body.size() + size > limits.maxBodyBytes)
+    {
+        fail(413);
+        return;
+    }
+    remaining = size;
+    state = State::CHUNK_DATA;
+}
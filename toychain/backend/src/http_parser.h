@@ -0,0 +1,126 @@
+#ifndef HTTP_PARSER_H
+#define HTTP_PARSER_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 서버가 받아 주는 요청 크기와 연결 유지 한도
+struct HttpLimits
+{
+    size_t maxHeaderBytes = 64 * 1024; // 요청줄 + 헤더 (+ chunked trailer)
+    size_t maxBodyBytes = 16u << 20;   // Content-Length 또는 chunk를 합친 본문
+    size_t maxHeaders = 100;
+    unsigned maxRequestsPerConnection = 1000; // 이만큼 응답하면 keep-alive 연결을 닫는다 (0이면 무제한)
+    int idleTimeoutSeconds = 60;              // 요청 사이(또는 요청 도중) 이만큼 조용하면 닫는다
+};
+
+struct HttpRequest
+{
+    std::string method;
+    std::string target;   // 요청줄의 경로 그대로 (쿼리 포함)
+    int versionMinor = 1; // HTTP/1.x의 x
+    std::vector<std::pair<std::string, std::string>> headers; // 이름은 소문자
+    std::string body;     // chunked면 이어 붙인 본문
+    bool keepAlive = true;
+
+    // 소문자 이름으로 찾는다. 없으면 nullptr
+    const std::string *header(const std::string &lowerName) const;
+    // 쿼리를 뺀 경로
+    std::string path() const;
+};
+
+// HttpBodyStream이 조각 하나를 만든 뒤의 상태
+enum class StreamStatus
+{
+    MORE, // 다음 조각도 바로 만들 수 있다
+    WAIT, // 지금은 보낼 것이 없다. 보낼 것이 생기면 wake를 부르고, 그때 서버가 다시 묻는다
+    DONE, // 이것이 마지막 조각이다
+};
+
+// 기다리는 스트림을 깨운다. 어느 스레드에서 불러도 되고, 연결이 이미 닫혔으면 아무것도 하지 않는다.
+// WAIT를 돌려줄 때마다 새로 등록해야 한다 (한 번 부르면 끝)
+using StreamWake = std::function<void()>;
+
+// 본문을 조금씩 만드는 함수. 다음 조각을 out에 덧붙이고 상태를 돌려준다. 조각이 비어 있어도 된다
+using HttpBodyStream = std::function<StreamStatus(std::string &out, const StreamWake &wake)>;
+
+struct HttpResponse
+{
+    int status = 200;
+    std::string contentType = "application/json";
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+    // 있으면 body 대신 이것으로 본문을 만든다. 서버는 앞 조각이 소켓으로 다 나간 뒤에 다음 조각을 요청한다
+    HttpBodyStream stream;
+};
+
+const char *httpStatusReason(int status);
+// 상태줄, Content-Length, Connection 헤더를 붙여 보낼 바이트열로 만든다.
+// stream 응답은 헤더까지만 만든다: chunked면 Transfer-Encoding: chunked, 아니면(HTTP/1.0) 연결을 닫아 끝을 알린다
+std::string serializeResponse(const HttpResponse &response, bool keepAlive, bool chunked = true);
+// chunked 조각을 out 안에서 바로 만든다: beginChunk가 크기 자리를 잡아 두고, 그 뒤에 내용을 덧붙인 다음
+// endChunk가 크기를 채운다 (내용이 비었으면 자리를 지운다). 조각을 따로 만들었다가 복사하지 않기 위해서다
+size_t beginChunk(std::string &out);
+void endChunk(std::string &out, size_t chunkStart);
+// 마지막 조각(끝 표시)
+void appendLastChunk(std::string &out);
+
+// 증분 HTTP/1.1 요청 파서.
+// 들어오는 대로 feed하면 요청 하나가 끝나는 지점에서 멈추므로, 남은 바이트는 다음(파이프라인된) 요청이다.
+// Content-Length와 chunked 본문을 처리하고, 한도를 넘거나 문법이 틀리면 응답할 상태 코드와 함께 실패한다.
+class HttpRequestParser
+{
+public:
+    explicit HttpRequestParser(const HttpLimits &limits);
+
+    // 읽어 들인 바이트 수를 돌려준다. complete()나 failed()가 되면 그 뒤는 읽지 않는다
+    size_t feed(const char *data, size_t len);
+
+    bool complete() const { return state == State::COMPLETE; }
+    bool failed() const { return state == State::FAILED; }
+    // 아직 요청의 어떤 바이트도 받지 않았다 (keep-alive 연결이 쉬는 중)
+    bool idle() const { return state == State::REQUEST_LINE && line.empty() && headerBytes == 0; }
+    int errorStatus() const { return error; }
+
+    // 헤더에 Expect: 100-continue가 있고 본문을 기다리는 중이면 한 번만 true
+    bool takeContinue();
+
+    // complete() 뒤에 요청을 꺼내고 다음 요청을 받을 준비를 한다
+    HttpRequest take();
+    void reset();
+
+private:
+    enum class State
+    {
+        REQUEST_LINE,
+        HEADERS,
+        BODY,
+        CHUNK_SIZE,
+        CHUNK_DATA,
+        CHUNK_END,
+        TRAILERS,
+        COMPLETE,
+        FAILED,
+    };
+
+    const HttpLimits &limits;
+    State state = State::REQUEST_LINE;
+    HttpRequest request;
+    std::string line;         // 아직 줄바꿈을 못 받은 줄
+    size_t headerBytes = 0;   // 요청줄 + 헤더 + trailer로 받은 바이트
+    size_t remaining = 0;     // 남은 본문 또는 현재 chunk 바이트
+    bool continuePending = false;
+    int error = 0;
+
+    void onLine();
+    void parseRequestLine();
+    void parseHeaderLine();
+    void finishHeaders();
+    void parseChunkSize();
+    void fail(int status);
+};
+
+#endif
@@ -0,0 +1,275 @@
+#include "json_reader.h"
+
+namespace
+{
+    bool isDigit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    int hexValue(char c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    }
+
+    void appendUtf8(std::string &out, unsigned long cp)
+    {
+        if (cp < 0x80)
+            out += (char)cp;
+        else if (cp < 0x800)
+        {
+            out += (char)(0xC0 | (cp >> 6));
+            out += (char)(0x80 | (cp & 0x3F));
+        }
+        else if (cp < 0x10000)
+        {
+            out += (char)(0xE0 | (cp >> 12));
+            out += (char)(0x80 | ((cp >> 6) & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
+        }
+        else
+        {
+            out += (char)(0xF0 | (cp >> 18));
+            out += (char)(0x80 | ((cp >> 12) & 0x3F));
+            out += (char)(0x80 | ((cp >> 6) & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
+        }
+    }
+}
+
+void JsonReader::fail(const char *what) const
+{
+    throw JsonError(std::string("invalid JSON at offset ") + std::to_string(pos) + ": " + what);
+}
+
+void JsonReader::expect(char c)
+{
+    if (!consume(c))
+        fail((std::string("expected '") + c + "'").c_str());
+}
+
+void JsonReader::enter(char open)
+{
+    expect(open);
+    if (++depth > MAX_DEPTH)
+        fail("nested too deeply");
+}
+
+std::string_view JsonReader::string()
+{
+    skipSpace();
+    return readString(buffer);
+}
+
+std::string_view JsonReader::readString(std::string &decoded)
+{
+    if (pos >= text.size() || text[pos] != '"')
+        fail("expected a string");
+    const size_t start = ++pos;
+
+    // 대부분의 값(해시, 주소)은 이스케이프가 없으므로 입력을 그대로 가리킨다
+    while (pos < text.size())
+    {
+        const unsigned char c = (unsigned char)text[pos];
+        if (c == '"')
+            return text.substr(start, pos++ - start);
+        if (c == '\\')
+            break;
+        if (c < 0x20)
+            fail("control character in string");
+        ++pos;
+    }
+    if (pos >= text.size())
+        fail("unterminated string");
+
+    decoded.assign(text.data() + start, pos - start);
+    while (pos < text.size())
+    {
+        const unsigned char c = (unsigned char)text[pos++];
+        if (c == '"')
+            return decoded;
+        if (c < 0x20)
+            fail("control character in string");
+        if (c != '\\')
+        {
+            decoded += (char)c;
+            continue;
+        }
+        if (pos >= text.size())
+            break;
+        switch (text[pos++])
+        {
+        case '"':
+            decoded += '"';
+            break;
+        case '\\':
+            decoded += '\\';
+            break;
+        case '/':
+            decoded += '/';
+            break;
+        case 'b':
+            decoded += '\b';
+            break;
+        case 'f':
+            decoded += '\f';
+            break;
+        case 'n':
+            decoded += '\n';
+            break;
+        case 'r':
+            decoded += '\r';
+            break;
+        case 't':
+            decoded += '\t';
+            break;
+        case 'u':
+        {
+            auto hex4 = [this]()
+            {
+                if (text.size() - pos < 4)
+                    fail("truncated \\u escape");
+                unsigned long v = 0;
+                for (int i = 0; i < 4; ++i)
+                {
+                    int h = hexValue(text[pos++]);
+                    if (h < 0)
+                        fail("invalid \\u escape");
+                    v = (v << 4) | (unsigned long)h;
+                }
+                return v;
+            };
+            unsigned long cp = hex4();
+            // UTF-16 surrogate pair
+            if (cp >= 0xD800 && cp < 0xDC00 && text.substr(pos, 2) == "\\u")
+            {
+                pos += 2;
+                unsigned long low = hex4();
+                if (low < 0xDC00 || low > 0xDFFF)
+                    fail("invalid surrogate pair");
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+            }
+            appendUtf8(decoded, cp);
+            break;
+        }
+        default:
+            fail("invalid escape");
+        }
+    }
+    fail("unterminated string");
+}
+
+std::string_view JsonReader::numberToken()
+{
+    skipSpace();
+    const size_t start = pos;
+    auto digits = [this]()
+    {
+        const size_t from = pos;
+        while (pos < text.size() && isDigit(text[pos]))
+            ++pos;
+        if (pos == from)
+            fail("expected a number");
+    };
+    if (pos < text.size() && text[pos] == '-')
+        ++pos;
+    digits();
+    if (pos < text.size() && text[pos] == '.')
+    {
+        ++pos;
+        digits();
+    }
+    if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E'))
+    {
+        ++pos;
+        if (pos < text.size() && (text[pos] == '+' || text[pos] == '-'))
+            ++pos;
+        digits();
+    }
+    return text.substr(start, pos - start);
+}
+
+double JsonReader::number()
+{
+    std::string_view token = numberToken();
+    double d = 0.0;
+    auto result = std::from_chars(token.data(), token.data() + token.size(), d);
+    if (result.ec != std::errc() || result.ptr != token.data() + token.size())
+        fail("number out of range");
+    return d;
+}
+
+void JsonReader::literal(std::string_view word)
+{
+    if (text.substr(pos, word.size()) != word)
+        fail("invalid literal");
+    pos += word.size();
+}
+
+bool JsonReader::boolean()
+{
+    skipSpace();
+    if (pos < text.size() && text[pos] == 't')
+    {
+        literal("true");
+        return true;
+    }
+    if (pos < text.size() && text[pos] == 'f')
+    {
+        literal("false");
+        return false;
+    }
+    fail("expected true or false");
+}
+
+bool JsonReader::null()
+{
+    skipSpace();
+    if (pos >= text.size() || text[pos] != 'n')
+        return false;
+    literal("null");
+    return true;
+}
+
+void JsonReader::skip()
+{
+    skipSpace();
+    if (pos >= text.size())
+        fail("expected a value");
+    switch (text[pos])
+    {
+    case '{':
+        object([](std::string_view)
+               { return false; });
+        break;
+    case '[':
+        array([this]()
+              { skip(); });
+        break;
+    case '"':
+        readString(buffer);
+        break;
+    case 't':
+    case 'f':
+        boolean();
+        break;
+    case 'n':
+        null();
+        break;
+    default:
+        numberToken();
+    }
+}
+
+void JsonReader::finish()
+{
+    skipSpace();
+    if (pos != text.size())
+        fail("trailing characters");
+}
@@ -0,0 +1,119 @@
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#include <charconv>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// 입력이 JSON 문법에 맞지 않을 때. what()에 입력 안의 위치가 들어 있다
+class JsonError : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// 입력을 앞에서부터 한 번만 훑으며 값을 꺼내는 pull 방식 JSON reader.
+// 트리를 만들지 않고, 호출한 쪽이 기대하는 구조대로 object()/array()/string()/number()를 부르면서 바로 객체를 만든다.
+// 문자열은 이스케이프가 없으면 입력을 가리키는 view로 돌려준다 (입력은 reader보다 오래 살아 있어야 한다).
+// 문법 오류, 기대와 다른 타입, 너무 깊은 중첩은 JsonError.
+class JsonReader
+{
+public:
+    static constexpr int MAX_DEPTH = 64;
+
+    explicit JsonReader(std::string_view text) : text(text) {}
+
+    // fn(std::string_view key) -> bool. fn은 값을 읽고 true를 돌려주거나, 모르는 키면 false를 돌려준다 (값을 건너뛴다).
+    // key는 값을 읽기 전까지만 유효하다.
+    template <typename Fn>
+    void object(Fn &&fn)
+    {
+        enter('{');
+        if (!consume('}'))
+        {
+            do
+            {
+                skipSpace();
+                std::string_view key = readString(keyBuffer);
+                expect(':');
+                if (!fn(key))
+                    skip();
+            } while (consume(','));
+            expect('}');
+        }
+        --depth;
+    }
+
+    // fn()이 원소 하나를 읽는다
+    template <typename Fn>
+    void array(Fn &&fn)
+    {
+        enter('[');
+        if (!consume(']'))
+        {
+            do
+                fn();
+            while (consume(','));
+            expect(']');
+        }
+        --depth;
+    }
+
+    // 다음 string() 호출 전까지 유효하다
+    std::string_view string();
+    double number();
+    bool boolean();
+    bool null(); // 다음 값이 null이면 읽고 true
+
+    template <typename Int>
+    Int integer()
+    {
+        static_assert(std::is_integral<Int>::value, "integer() needs an integral type");
+        std::string_view digits = numberToken();
+        Int n = 0;
+        auto result = std::from_chars(digits.data(), digits.data() + digits.size(), n);
+        if (result.ec != std::errc() || result.ptr != digits.data() + digits.size())
+            fail("expected an integer");
+        return n;
+    }
+
+    // 다음 값을 통째로 건너뛴다
+    void skip();
+    // 입력 끝까지 공백만 남았는지 확인한다
+    void finish();
+
+    [[noreturn]] void fail(const char *what) const;
+
+private:
+    std::string_view text;
+    size_t pos = 0;
+    int depth = 0;
+    std::string buffer;    // 이스케이프를 푼 문자열 값
+    std::string keyBuffer; // 이스케이프를 푼 키 (값을 읽는 동안 남아 있어야 한다)
+
+    void skipSpace()
+    {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r'))
+            ++pos;
+    }
+    bool consume(char c)
+    {
+        skipSpace();
+        if (pos < text.size() && text[pos] == c)
+        {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+    void expect(char c);
+    void enter(char open);
+    std::string_view readString(std::string &decoded);
+    std::string_view numberToken();
+    void literal(std::string_view word);
+};
+
+#endif
@@ -0,0 +1,74 @@
+#include "json_writer.h"
+#include <cmath>
+
+namespace
+{
+    const char HEX_DIGITS[] = "0123456789abcdef";
+}
+
+JsonWriter &JsonWriter::value(double d)
+{
+    if (!std::isfinite(d))
+        return value(nullptr);
+    separate();
+    char digits[32];
+    auto result = std::to_chars(digits, digits + sizeof(digits), d);
+    out.append(digits, (size_t)(result.ptr - digits));
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(const Hash256 &hash)
+{
+    if (hash.isNull())
+        return value(std::string_view("0")); // Hash256::toHex와 같은 표기 (제네시스 previousHash)
+    separate();
+    const size_t start = out.size();
+    out.resize(start + 2 + 2 * Sha256::DIGEST_SIZE);
+    char *p = &out[start];
+    *p++ = '"';
+    for (unsigned char byte : hash.bytes)
+    {
+        *p++ = HEX_DIGITS[byte >> 4];
+        *p++ = HEX_DIGITS[byte & 0x0f];
+    }
+    *p = '"';
+    return *this;
+}
+
+void JsonWriter::appendString(std::string_view s)
+{
+    out += '"';
+    size_t plain = 0; // 이스케이프가 필요 없는 구간은 한 번에 붙인다
+    for (size_t i = 0; i < s.size(); ++i)
+    {
+        const unsigned char c = (unsigned char)s[i];
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+        out.append(s.data() + plain, i - plain);
+        plain = i + 1;
+        switch (c)
+        {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\r':
+            out += "\\r";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        default:
+            out += "\\u00";
+            out += HEX_DIGITS[c >> 4];
+            out += HEX_DIGITS[c & 0x0f];
+        }
+    }
+    out.append(s.data() + plain, s.size() - plain);
+    out += '"';
+}
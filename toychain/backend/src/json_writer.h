@@ -0,0 +1,128 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include "crypto.h"
+#include <charconv>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// std::string 버퍼에 JSON을 바로 써 넣는 writer. 값마다 임시 문자열을 만들지 않고 쉼표는 알아서 넣는다.
+// 버퍼는 호출한 쪽 것이라, clear()한 버퍼를 다시 넘기면 용량을 그대로 재사용한다.
+// 도메인 타입은 writeJson(JsonWriter &, const T &) 오버로드를 두면 value() / field() / array()로 쓸 수 있다.
+class JsonWriter
+{
+public:
+    explicit JsonWriter(std::string &out) : out(out) {}
+
+    JsonWriter &beginObject() { return open('{'); }
+    JsonWriter &endObject() { return close('}'); }
+    JsonWriter &beginArray() { return open('['); }
+    JsonWriter &endArray() { return close(']'); }
+
+    JsonWriter &key(std::string_view name)
+    {
+        separate();
+        appendString(name);
+        out += ':';
+        first = true; // 값 앞에는 쉼표를 넣지 않는다
+        return *this;
+    }
+
+    JsonWriter &value(std::string_view s)
+    {
+        separate();
+        appendString(s);
+        return *this;
+    }
+    JsonWriter &value(const std::string &s) { return value(std::string_view(s)); }
+    JsonWriter &value(const char *s) { return value(std::string_view(s)); }
+    JsonWriter &value(bool b)
+    {
+        separate();
+        out += b ? "true" : "false";
+        return *this;
+    }
+    JsonWriter &value(std::nullptr_t)
+    {
+        separate();
+        out += "null";
+        return *this;
+    }
+    // 왕복 변환되는 가장 짧은 표기. 유한하지 않으면 null
+    JsonWriter &value(double d);
+    // Hash256::toHex와 같은 문자열 (64자리 소문자 hex, 0이면 "0")
+    JsonWriter &value(const Hash256 &hash);
+
+    template <typename Int, typename std::enable_if<std::is_integral<Int>::value && !std::is_same<Int, bool>::value, int>::type = 0>
+    JsonWriter &value(Int n)
+    {
+        separate();
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), n);
+        out.append(digits, (size_t)(result.ptr - digits));
+        return *this;
+    }
+
+    // 그 밖의 타입은 writeJson 오버로드로 쓴다
+    template <typename T, typename std::enable_if<!std::is_arithmetic<T>::value, int>::type = 0>
+    JsonWriter &value(const T &item)
+    {
+        writeJson(*this, item);
+        return *this;
+    }
+
+    template <typename T>
+    JsonWriter &field(std::string_view name, const T &item)
+    {
+        key(name);
+        return value(item);
+    }
+
+    template <typename Range>
+    JsonWriter &array(const Range &items)
+    {
+        beginArray();
+        for (const auto &item : items)
+            value(item);
+        return endArray();
+    }
+
+    // 이미 JSON인 조각을 값 하나로 그대로 넣는다
+    JsonWriter &raw(std::string_view json)
+    {
+        separate();
+        out.append(json.data(), json.size());
+        return *this;
+    }
+
+    std::string &buffer() { return out; }
+
+private:
+    std::string &out;
+    bool first = true; // 지금 위치가 배열/객체의 첫 항목이거나 key 바로 뒤다
+
+    void separate()
+    {
+        if (!first)
+            out += ',';
+        first = false;
+    }
+    JsonWriter &open(char c)
+    {
+        separate();
+        out += c;
+        first = true;
+        return *this;
+    }
+    JsonWriter &close(char c)
+    {
+        out += c;
+        first = false;
+        return *this;
+    }
+    void appendString(std::string_view s);
+};
+
+#endif
@@ -1,36 +1,97 @@
 #include "blockchain.h"
+#include "storage.h"
 #include <iostream>
+#include <cstdlib>
+#include <filesystem>
 #include "db/Database.hpp"
 
 // 전방 선언
-void runServer(Blockchain &blockchain, const std::string &statePath);
+void runServer(Blockchain &blockchain);
 
 int main()
 {
     Blockchain chain;
     chain.setDifficulty(3);
 
+    const char *envThreads = std::getenv("MINING_THREADS");
+    if (envThreads)
+    {
+        chain.setMiningThreads(static_cast<unsigned>(std::atoi(envThreads)));
+    }
+
     const std::string dataDir = "../data";
     const std::string dbPath = dataDir + "/chain.db";
 
     Database db(dbPath);
-    if (db.isOpen())
+
+    // 블록 로그: N개 레코드마다 fsync (기본 1 = 블록마다, 0 = OS에 맡김)
+    unsigned syncEvery = 1;
+    const char *envSync = std::getenv("BLOCKLOG_SYNC_EVERY");
+    if (envSync)
     {
-        chain.attachDatabase(&db);
+        syncEvery = static_cast<unsigned>(std::atoi(envSync));
     }
 
-    const std::string statePath = "../data/chain.dat";
-    if (chain.loadFromFile(statePath))
+    // UTXO 스냅샷: N블록마다 백그라운드로 기록 (기본 100, 0 = 쓰지 않음)
+    unsigned snapshotEvery = 100;
+    const char *envSnapshot = std::getenv("UTXO_SNAPSHOT_EVERY");
+    if (envSnapshot)
     {
-        std::cout << "Loaded blockchain state from " << statePath << "\n";
+        snapshotEvery = static_cast<unsigned>(std::atoi(envSnapshot));
+    }
+
+    const std::string logPath = dataDir + "/chain.log";
+    const std::string statePath = dataDir + "/chain.dat"; // 예전 텍스트 형식, 한 번만 로그로 옮긴다
+    BlockLog blockLog(logPath, syncEvery);
+    UTXOSnapshotter snapshotter(dataDir + "/utxo.snapshot");
+    chain.attachSnapshotter(&snapshotter, snapshotEvery);
+
+    const bool logReady = chain.loadFromLog(blockLog);
+    if (logReady)
+    {
+        if (blockLog.getBlockCount() > 0)
+        {
+            std::cout << "Loaded blockchain from " << logPath << " (" << chain.getChain().size() << " blocks)\n";
+        }
+        else if (chain.loadFromFile(statePath))
+        {
+            std::cout << "Migrating " << statePath << " to " << logPath << "\n";
+            if (chain.writeToLog(blockLog))
+            {
+                std::error_code ec;
+                std::filesystem::rename(statePath, statePath + ".migrated", ec);
+            }
+            else
+            {
+                std::cerr << "❌ Migration to " << logPath << " failed\n";
+            }
+        }
+        else
+        {
+            std::cout << "Starting new chain (no persisted state found).\n";
+            chain.writeToLog(blockLog);
+        }
     }
     else
     {
-        std::cout << "Starting new chain (no persisted state found).\n";
+        std::cerr << "❌ Block log unavailable, new blocks will not be persisted\n";
+    }
+    if (db.isOpen())
+    {
+        chain.backfillDatabase(db);
+        std::vector<Hash256> dropped = chain.restoreMempool(db.loadMempool());
+        if (!dropped.empty())
+        {
+            db.removeMempool(dropped);
+        }
     }
 
+    // 이후의 쓰기는 모두 persistence 스레드가 맡는다 (요청/채굴 스레드는 디스크를 기다리지 않는다)
+    PersistencePipeline persistence(logReady ? &blockLog : nullptr, db.isOpen() ? &db : nullptr, &snapshotter);
+    chain.attachPersistence(&persistence);
+
     std::cout << "Starting ToyChain Blockchain Server...\n";
-    runServer(chain, statePath);
+    runServer(chain);
 
     return 0;
 }
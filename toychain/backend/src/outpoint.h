@@ -0,0 +1,30 @@
+#ifndef OUTPOINT_H
+#define OUTPOINT_H
+
+#include "crypto.h"
+#include <cstdint>
+
+// 특정 트랜잭션의 특정 output을 가리키는 좌표 (txId + output index, 36바이트)
+// UTXOSet의 key로 쓰인다. 문자열 "txId:index"를 만들고 다시 파싱하던 비용을 없앤다.
+struct OutPoint
+{
+    Hash256 txId;
+    uint32_t index = 0;
+
+    OutPoint() = default;
+    OutPoint(const Hash256 &id, uint32_t idx) : txId(id), index(idx) {}
+
+    bool operator==(const OutPoint &other) const { return index == other.index && txId == other.txId; }
+    bool operator!=(const OutPoint &other) const { return !(*this == other); }
+};
+
+struct OutPointHasher
+{
+    size_t operator()(const OutPoint &op) const
+    {
+        // 같은 트랜잭션의 output들이 서로 다른 bucket으로 흩어지도록 index를 곱해 섞는다
+        return Hash256Hasher()(op.txId) ^ (static_cast<size_t>(op.index) * 0x9E3779B97F4A7C15ULL);
+    }
+};
+
+#endif
@@ -0,0 +1,201 @@
+#include "persistence.h"
+#include <iostream>
+
+PersistencePipeline::PersistencePipeline(BlockLog *log, Database *db, UTXOSnapshotter *snapshotter, size_t capacity)
+    : log(log), db(db), snapshotter(snapshotter), capacity(capacity > 0 ? capacity : 1),
+      syncEvery(log ? log->getSyncEvery() : 0)
+{
+    // fsync 시점은 그룹 단위로 여기서 정한다
+    if (log)
+        log->setSyncEvery(0);
+    worker = std::thread(&PersistencePipeline::run, this);
+}
+
+PersistencePipeline::~PersistencePipeline()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    notEmpty.notify_all();
+    worker.join();
+
+    if (log)
+    {
+        log->sync();
+        log->setSyncEvery(syncEvery);
+    }
+}
+
+uint64_t PersistencePipeline::submitBlock(const Block *block)
+{
+    Event event;
+    event.type = EventType::BLOCK;
+    event.block = block;
+    return submit(std::move(event));
+}
+
+uint64_t PersistencePipeline::submitDifficulty(int difficulty)
+{
+    Event event;
+    event.type = EventType::DIFFICULTY;
+    event.difficulty = difficulty;
+    return submit(std::move(event));
+}
+
+uint64_t PersistencePipeline::submitMempool(std::vector<UTXOTransaction> added, std::vector<Hash256> removed)
+{
+    Event event;
+    event.type = EventType::MEMPOOL;
+    event.added = std::move(added);
+    event.removed = std::move(removed);
+    return submit(std::move(event));
+}
+
+uint64_t PersistencePipeline::submitSnapshot(std::shared_ptr<const UTXOSet> frozen, uint64_t height, const Hash256 &tip)
+{
+    Event event;
+    event.type = EventType::SNAPSHOT;
+    event.utxo = std::move(frozen);
+    event.height = height;
+    event.tip = tip;
+    return submit(std::move(event));
+}
+
+uint64_t PersistencePipeline::submit(Event event)
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    notFull.wait(lock, [this]
+                 { return queue.size() < capacity; });
+    event.seq = ++submitted;
+    const uint64_t seq = event.seq;
+    queue.push_back(std::move(event));
+    lock.unlock();
+    notEmpty.notify_one();
+    return seq;
+}
+
+bool PersistencePipeline::waitDurable(uint64_t seq)
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    durableCv.wait(lock, [&]
+                   { return durable >= seq; });
+    for (const auto &[first, last] : failedGroups)
+    {
+        if (first <= seq && seq <= last)
+            return false;
+    }
+    return true;
+}
+
+uint64_t PersistencePipeline::getDurableSequence() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return durable;
+}
+
+uint64_t PersistencePipeline::getSubmittedSequence() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return submitted;
+}
+
+void PersistencePipeline::run()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true)
+    {
+        notEmpty.wait(lock, [this]
+                      { return !queue.empty() || stopping; });
+        if (queue.empty())
+            return; // stopping, 남은 이벤트 없음
+
+        // 지금까지 쌓인 이벤트를 한 그룹으로 가져간다
+        std::vector<Event> group;
+        group.reserve(queue.size());
+        while (!queue.empty())
+        {
+            group.push_back(std::move(queue.front()));
+            queue.pop_front();
+        }
+        lock.unlock();
+        notFull.notify_all();
+
+        const uint64_t first = group.front().seq;
+        const uint64_t last = group.back().seq;
+        bool ok = writeGroup(group);
+        group.clear();
+
+        lock.lock();
+        if (!ok)
+            failedGroups.emplace_back(first, last);
+        durable = last;
+        durableCv.notify_all();
+    }
+}
+
+bool PersistencePipeline::writeGroup(std::vector<Event> &group)
+{
+    bool ok = true;
+
+    // 1) 블록 로그: 기록 순서가 곧 체인 순서
+    if (log)
+    {
+        unsigned written = 0;
+        for (const auto &event : group)
+        {
+            if (event.type == EventType::BLOCK)
+                ok = log->appendBlock(*event.block) && ok;
+            else if (event.type == EventType::DIFFICULTY)
+                ok = log->appendDifficulty(event.difficulty) && ok;
+            else
+                continue;
+            ++written;
+        }
+        unsynced += written;
+        if (syncEvery > 0 && unsynced >= syncEvery)
+        {
+            ok = log->sync() && ok;
+            unsynced = 0;
+        }
+    }
+
+    // 2) SQLite: 그룹 전체를 한 트랜잭션으로. mempool 변경분은 들어온 순서대로 적용한다
+    if (db)
+    {
+        bool dbOk = db->beginBatch();
+        for (const auto &event : group)
+        {
+            if (event.type == EventType::BLOCK)
+            {
+                db->insertBlock(*event.block, event.block->getTransactions());
+            }
+            else if (event.type == EventType::MEMPOOL)
+            {
+                if (!event.removed.empty())
+                    db->removeMempool(event.removed);
+                if (!event.added.empty())
+                    db->insertMempool(event.added);
+            }
+        }
+        dbOk = dbOk && db->commitBatch();
+        if (!dbOk)
+            std::cerr << "❌ Database write failed for " << group.size() << " persistence events\n";
+        ok = dbOk && ok;
+    }
+
+    // 3) 스냅샷: 해당 높이까지의 로그가 기록된 뒤에만 넘긴다 (스냅샷이 로그보다 앞서지 않도록)
+    if (snapshotter)
+    {
+        for (auto it = group.rbegin(); it != group.rend(); ++it)
+        {
+            if (it->type == EventType::SNAPSHOT)
+            {
+                snapshotter->schedule(std::move(it->utxo), it->height, it->tip);
+                break;
+            }
+        }
+    }
+
+    return ok;
+}
@@ -0,0 +1,98 @@
+#ifndef PERSISTENCE_H
+#define PERSISTENCE_H
+
+#include "block.h"
+#include "snapshot.h"
+#include "storage.h"
+#include "utxo.h"
+#include "db/Database.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// 블록 로그 / SQLite / UTXO 스냅샷 쓰기를 전담하는 스레드.
+//
+// 채굴·요청 스레드는 이벤트를 큐에 넣고 바로 돌아간다. 이벤트마다 1부터 증가하는 sequence가 붙고,
+// 스레드는 쌓인 이벤트를 한 번에 꺼내 처리한다 (group commit):
+//   1) 블록/난이도 레코드를 순서대로 로그에 쓰고 fsync는 그룹당 한 번 (BLOCKLOG_SYNC_EVERY 정책에 따라)
+//   2) SQLite에는 그룹 전체를 한 트랜잭션으로 (mempool은 추가/제거된 트랜잭션만)
+//   3) 스냅샷은 그 높이까지의 로그가 기록된 뒤에 UTXOSnapshotter로 넘긴다
+// 그룹이 끝나면 durable sequence가 그룹의 마지막 sequence로 올라간다.
+// 쓰기 결과를 기다려야 하는 호출자만 waitDurable(seq)로 기다린다.
+//
+// 큐는 capacity개로 제한되며 가득 차면 submit이 자리가 날 때까지 기다린다.
+class PersistencePipeline
+{
+public:
+    // log/db/snapshotter는 nullptr이면 해당 이벤트를 건너뛴다. 모두 파이프라인보다 오래 살아야 한다.
+    PersistencePipeline(BlockLog *log, Database *db, UTXOSnapshotter *snapshotter, size_t capacity = 1024);
+    // 남은 이벤트를 모두 기록한 뒤 스레드를 끝낸다
+    ~PersistencePipeline();
+
+    PersistencePipeline(const PersistencePipeline &) = delete;
+    PersistencePipeline &operator=(const PersistencePipeline &) = delete;
+
+    // block은 기록이 끝날 때까지 주소가 유지되어야 한다 (ChainStore에 들어간 블록)
+    uint64_t submitBlock(const Block *block);
+    uint64_t submitDifficulty(int difficulty);
+    // mempool 변경분: added는 새로 들어온 트랜잭션, removed는 빠진 트랜잭션 id
+    uint64_t submitMempool(std::vector<UTXOTransaction> added, std::vector<Hash256> removed);
+    // frozen은 이후 바뀌지 않아야 한다 (복사하지 않고 스냅샷 스레드와 나눠 쓴다)
+    uint64_t submitSnapshot(std::shared_ptr<const UTXOSet> frozen, uint64_t height, const Hash256 &tip);
+
+    // seq까지 기록되면 true. 그 사이 쓰기 실패가 있었으면 false
+    bool waitDurable(uint64_t seq);
+    uint64_t getDurableSequence() const;
+    uint64_t getSubmittedSequence() const;
+
+private:
+    enum class EventType
+    {
+        BLOCK,
+        DIFFICULTY,
+        MEMPOOL,
+        SNAPSHOT,
+    };
+
+    struct Event
+    {
+        EventType type = EventType::BLOCK;
+        uint64_t seq = 0;
+        const Block *block = nullptr;
+        int difficulty = 0;
+        std::vector<UTXOTransaction> added;
+        std::vector<Hash256> removed;
+        std::shared_ptr<const UTXOSet> utxo;
+        uint64_t height = 0;
+        Hash256 tip{};
+    };
+
+    BlockLog *log;
+    Database *db;
+    UTXOSnapshotter *snapshotter;
+    size_t capacity;
+    unsigned syncEvery;     // 로그의 원래 fsync 주기. 파이프라인이 직접 센다
+    unsigned unsynced = 0;
+
+    mutable std::mutex mtx;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::condition_variable durableCv;
+    std::deque<Event> queue;
+    uint64_t submitted = 0;
+    uint64_t durable = 0;
+    std::vector<std::pair<uint64_t, uint64_t>> failedGroups; // 쓰기에 실패한 그룹의 [첫, 마지막] sequence
+    bool stopping = false;
+    std::thread worker;
+
+    uint64_t submit(Event event);
+    void run();
+    bool writeGroup(std::vector<Event> &group);
+};
+
+#endif
@@ -1 +1,90 @@
-// ...existing code from src/pow.cpp...
\ No newline at end of file
+#include "pow.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+ParallelMiner::ParallelMiner(unsigned threads)
+    : threadCount(threads == 0 ? defaultThreadCount() : threads)
+{
+}
+
+unsigned ParallelMiner::defaultThreadCount()
+{
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw == 0 ? 1 : hw;
+}
+
+ParallelMiner::Result ParallelMiner::search(int difficulty, int startNonce, const HashRangeFn &hashRange, const SampleFn &onSample,
+                                            const StopFn &shouldStop) const
+{
+    Result result;
+    std::atomic<bool> found{false};
+    std::atomic<bool> stopped{false};
+    std::mutex resultMutex;
+    std::mutex sampleMutex;
+
+    auto worker = [&](unsigned w)
+    {
+        Hash256 hashes[BATCH];
+        const long long stride = static_cast<long long>(threadCount) * BATCH;
+
+        for (long long first = static_cast<long long>(startNonce) + static_cast<long long>(w) * BATCH; first <= INT_MAX; first += stride)
+        {
+            if (found.load(std::memory_order_relaxed) || stopped.load(std::memory_order_relaxed))
+                return;
+            if (shouldStop && shouldStop())
+            {
+                stopped.store(true, std::memory_order_relaxed);
+                return;
+            }
+
+            int count = static_cast<int>(std::min<long long>(BATCH, static_cast<long long>(INT_MAX) - first + 1));
+            hashRange(static_cast<int>(first), count, hashes);
+
+            for (int i = 0; i < count; ++i)
+            {
+                int nonce = static_cast<int>(first + i);
+                if (hashes[i].meetsDifficulty(difficulty))
+                {
+                    std::lock_guard<std::mutex> lock(resultMutex);
+                    if (!found.exchange(true))
+                    {
+                        result.found = true;
+                        result.nonce = nonce;
+                        result.hash = hashes[i];
+                    }
+                    return;
+                }
+
+                if (onSample && nonce % 5000 == 0)
+                {
+                    std::lock_guard<std::mutex> lock(sampleMutex);
+                    onSample(hashes[i], nonce);
+                }
+            }
+        }
+    };
+
+    if (threadCount == 1)
+    {
+        worker(0);
+        result.stopped = !result.found && stopped.load();
+        return result;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(threadCount);
+    for (unsigned w = 0; w < threadCount; ++w)
+    {
+        workers.emplace_back(worker, w);
+    }
+    for (auto &t : workers)
+    {
+        t.join();
+    }
+    result.stopped = !result.found && stopped.load();
+    return result;
+}
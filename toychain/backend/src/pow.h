@@ -0,0 +1,48 @@
+#ifndef POW_H
+#define POW_H
+
+#include "crypto.h"
+#include <functional>
+
+// 작업증명(PoW) nonce 탐색 엔진
+// nonce 공간을 BATCH개씩 연속된 묶음으로 잘라 worker thread에 번갈아 나눠 주고
+// (worker w는 묶음 w, w+T, w+2T, ...), 한 worker가 목표 해시를 찾으면 나머지도 즉시 멈춘다.
+// 묶음 안의 연속 nonce는 multi-buffer SHA-256 lane에 실려 함께 해시된다.
+class ParallelMiner
+{
+public:
+    // hashRange(first, count, out): nonce first .. first+count-1 의 해시를 out[0..count)에 채운다
+    using HashRangeFn = std::function<void(int, int, Hash256 *)>;
+    using SampleFn = std::function<void(const Hash256 &, int)>;
+    // 탐색을 그만둘지. worker마다 BATCH개를 해시할 때마다 부르므로 가벼워야 하고 thread-safe 해야 한다
+    using StopFn = std::function<bool()>;
+
+    struct Result
+    {
+        bool found = false;
+        bool stopped = false; // shouldStop으로 멈췄다
+        int nonce = 0;
+        Hash256 hash;
+    };
+
+    static constexpr int BATCH = 64;
+
+    // threads == 0 이면 하드웨어 스레드 수를 사용
+    explicit ParallelMiner(unsigned threads = 0);
+
+    unsigned getThreadCount() const { return threadCount; }
+
+    // startNonce ~ INT_MAX 구간에서 difficulty를 만족하는 nonce를 찾는다.
+    // hashRange는 여러 스레드에서 동시에 호출되므로 thread-safe 해야 한다.
+    // onSample은 nonce % 5000 == 0 마다 호출되며, 호출 자체는 직렬화된다.
+    // shouldStop이 true를 돌려주면 찾지 못한 채 stopped로 끝난다.
+    Result search(int difficulty, int startNonce, const HashRangeFn &hashRange, const SampleFn &onSample = nullptr,
+                  const StopFn &shouldStop = nullptr) const;
+
+    static unsigned defaultThreadCount();
+
+private:
+    unsigned threadCount;
+};
+
+#endif
@@ -0,0 +1,73 @@
+#include "sample_ring.h"
+#include <algorithm>
+#include <cstring>
+
+SampleRing::SampleRing(size_t capacity)
+    : slotCount(std::max<size_t>(1, capacity)), slots(new Slot[slotCount])
+{
+}
+
+void SampleRing::push(const MiningSample &sample)
+{
+    const uint64_t n = head.load(std::memory_order_relaxed);
+    Slot &slot = slots[n % slotCount];
+
+    uint64_t words[WORDS];
+    words[0] = (uint64_t)(uint32_t)sample.nonce;
+    std::memcpy(&words[1], sample.hash.data(), Sha256::DIGEST_SIZE);
+
+    // seqlock 쓰기: 홀수 표시 → 내용 → 짝수 표시. 내용도 atomic word라 reader와 겹쳐도 data race가 아니다
+    slot.seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < WORDS; ++i)
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+    slot.seq.store(2 * n + 2, std::memory_order_release);
+    head.store(n + 1, std::memory_order_release);
+}
+
+bool SampleRing::readSlot(uint64_t n, MiningSample &out) const
+{
+    const Slot &slot = slots[n % slotCount];
+    const uint64_t before = slot.seq.load(std::memory_order_acquire);
+    if (before != 2 * n + 2)
+        return false; // 이미 더 새 샘플이 들어왔거나 쓰는 중이다
+
+    uint64_t words[WORDS];
+    for (size_t i = 0; i < WORDS; ++i)
+        words[i] = slot.words[i].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.seq.load(std::memory_order_relaxed) != before)
+        return false; // 읽는 동안 덮어쓰였다
+
+    out.nonce = (int)(uint32_t)words[0];
+    std::memcpy(out.hash.data(), &words[1], Sha256::DIGEST_SIZE);
+    return true;
+}
+
+uint64_t SampleRing::read(uint64_t from, std::vector<MiningSample> &out, uint64_t &skipped) const
+{
+    out.clear();
+    const uint64_t end = head.load(std::memory_order_acquire);
+    if (from > end)
+        from = end;
+    const uint64_t oldest = end > slotCount ? end - slotCount : 0;
+    if (from < oldest)
+    {
+        skipped += oldest - from;
+        from = oldest;
+    }
+
+    MiningSample sample;
+    for (uint64_t n = from; n < end; ++n)
+    {
+        if (readSlot(n, sample))
+        {
+            out.push_back(sample);
+            continue;
+        }
+        // writer가 따라잡아 n을 덮어썼다: 그 앞은 더 오래됐으므로 버리고 n 다음부터 이어 받는다
+        skipped += out.size() + 1;
+        out.clear();
+    }
+    return end;
+}
@@ -0,0 +1,59 @@
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#include "crypto.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// 채굴 중 몇 천 nonce마다 남기는 샘플 하나
+struct MiningSample
+{
+    int nonce = 0;
+    Hash256 hash;
+};
+
+// 고정 용량의 single-producer / multi-consumer 샘플 링.
+// 만들 때 슬롯을 모두 할당하고, push는 잠금도 할당도 없이 가장 오래된 슬롯을 덮어쓴다.
+// 슬롯마다 seqlock 번호를 두어 reader는 잠금 없이 읽고, 읽는 동안 덮어쓰인 샘플은 버린다.
+// 샘플에는 0부터 순서 번호가 붙고 reader는 "다음에 읽을 번호"만 들고 있으면 된다.
+class SampleRing
+{
+public:
+    explicit SampleRing(size_t capacity);
+
+    SampleRing(const SampleRing &) = delete;
+    SampleRing &operator=(const SampleRing &) = delete;
+
+    size_t capacity() const { return slotCount; }
+    // 지금까지 push된 샘플 수 (= 다음 샘플의 번호)
+    uint64_t published() const { return head.load(std::memory_order_acquire); }
+
+    // writer 스레드 하나에서만 부른다
+    void push(const MiningSample &sample);
+
+    // 번호 from부터 지금까지의 샘플 중 남아 있는 것을 오래된 순서로 out에 담고(out은 비운 뒤 채운다),
+    // 다음에 읽을 번호를 돌려준다. out은 항상 빈틈 없이 이어진 구간이고, 그 앞에서 이미 덮어쓰여
+    // 읽지 못한 샘플 수는 skipped에 더한다.
+    uint64_t read(uint64_t from, std::vector<MiningSample> &out, uint64_t &skipped) const;
+
+private:
+    static constexpr size_t WORDS = 5; // nonce 1 + hash 4 (64비트 단위)
+
+    // seq: 2n+1이면 n번 샘플을 쓰는 중, 2n+2면 n번 샘플이 다 들어 있다
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> seq{0};
+        std::atomic<uint64_t> words[WORDS];
+    };
+
+    size_t slotCount;
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<uint64_t> head{0};
+
+    bool readSlot(uint64_t n, MiningSample &out) const;
+};
+
+#endif
@@ -1,19 +1,27 @@
 #include "blockchain.h"
 #include "server.h"
+#include "chain_json.h"
+#include "event_loop.h"
+#include "worker_pool.h"
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <unistd.h>
 #include <iostream>
 #include <sstream>
 #include <cstring>
+#include <cerrno>
 #include <thread>
 #include <mutex>
+#include <atomic>
 #include <unordered_map>
 #include <memory>
+#include <optional>
 #include <random>
 #include <chrono>
 #include <functional>
 #include <tuple>
+#include <algorithm>
 #include <stdexcept>
 #include <cstdlib>
 #include <netdb.h>
@@ -51,18 +59,40 @@ static ParsedUrl parseUrl(const std::string &url)
     return u;
 }
 
-static void postToPeer(const std::string &peerUrl, const std::string &path, const std::string &body)
+static bool sendAll(int sock, const std::string &data)
+{
+    size_t sent = 0;
+    while (sent < data.size())
+    {
+        ssize_t n = send(sock, data.data() + sent, data.size() - sent, 0);
+        if (n <= 0)
+            return false;
+        sent += (size_t)n;
+    }
+    return true;
+}
+
+// 피어마다 연결 하나를 keep-alive로 재사용한다 (전파할 때마다 TCP 연결을 새로 맺지 않도록)
+struct PeerConnection
+{
+    std::mutex mtx;
+    int fd = -1;
+};
+
+static std::unordered_map<std::string, std::unique_ptr<PeerConnection>> peerConnections;
+static std::mutex peerConnectionsMutex;
+
+static int connectToPeer(const ParsedUrl &p)
 {
-    ParsedUrl p = parseUrl(peerUrl);
     int sock = socket(AF_INET, SOCK_STREAM, 0);
     if (sock < 0)
-        return;
+        return -1;
 
     struct hostent *server = gethostbyname(p.host.c_str());
     if (!server)
     {
         close(sock);
-        return;
+        return -1;
     }
 
     struct sockaddr_in serv_addr;
@@ -74,20 +104,66 @@ static void postToPeer(const std::string &peerUrl, const std::string &path, cons
     if (connect(sock, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0)
     {
         close(sock);
-        return;
+        return -1;
+    }
+    int opt = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    return sock;
+}
+
+// 응답 내용은 쓰지 않으므로 다음 요청을 보내기 전에 쌓인 만큼 읽어 버린다. 피어가 연결을 닫았으면 false
+static bool drainPeerResponses(int sock)
+{
+    char buffer[4096];
+    while (true)
+    {
+        ssize_t n = recv(sock, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (n > 0)
+            continue;
+        if (n < 0 && errno == EINTR)
+            continue;
+        return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
     }
+}
 
+static void postToPeer(const std::string &peerUrl, const std::string &path, const std::string &body)
+{
+    PeerConnection *conn;
+    {
+        std::lock_guard<std::mutex> lock(peerConnectionsMutex);
+        auto &slot = peerConnections[peerUrl];
+        if (!slot)
+            slot = std::make_unique<PeerConnection>();
+        conn = slot.get();
+    }
+
+    ParsedUrl p = parseUrl(peerUrl);
     std::stringstream req;
     req << "POST " << path << " HTTP/1.1\r\n";
     req << "Host: " << p.host << "\r\n";
     req << "Content-Type: application/json\r\n";
-    req << "Content-Length: " << body.size() << "\r\n";
-    req << "Connection: close\r\n\r\n";
+    req << "Content-Length: " << body.size() << "\r\n\r\n";
     req << body;
-
     auto reqStr = req.str();
-    send(sock, reqStr.c_str(), reqStr.size(), 0);
-    close(sock);
+
+    std::lock_guard<std::mutex> lock(conn->mtx);
+    // 재사용한 연결이 그새 끊겼으면 한 번만 새로 연결해 다시 보낸다
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        if (conn->fd >= 0 && !drainPeerResponses(conn->fd))
+        {
+            close(conn->fd);
+            conn->fd = -1;
+        }
+        if (conn->fd < 0)
+            conn->fd = connectToPeer(p);
+        if (conn->fd < 0)
+            return;
+        if (sendAll(conn->fd, reqStr))
+            return;
+        close(conn->fd);
+        conn->fd = -1;
+    }
 }
 
 static void broadcastJson(const std::string &path, const std::string &body)
@@ -117,818 +193,750 @@ static void initPeersFromEnv()
     }
 }
 
-// 매우 단순한 파서: 문자열을 찾아서 잘라내는 방식
-static std::string extract(const std::string &body, const std::string &key)
+// 요청 본문(JSON 객체)의 최상위 필드를 fn(key, reader)로 넘긴다. fn은 값을 읽었으면 true, 모르는 키면 false.
+// 본문이 비어 있으면 아무것도 하지 않는다. 형식이 틀리면 JsonError
+template <typename Fn>
+static void readBodyFields(const std::string &body, Fn &&fn)
 {
-    auto pos = body.find(key);
-    if (pos == std::string::npos)
-        return "";
-    pos += key.size();
-    auto end = body.find_first_of(",}", pos);
-    return body.substr(pos, end - pos);
+    if (body.find_first_not_of(" \t\r\n") == std::string::npos)
+        return;
+    JsonReader r(body);
+    r.object([&](std::string_view key)
+             { return fn(key, r); });
+    r.finish();
 }
 
-static std::string extractQuoted(const std::string &body, const std::string &key)
+// 본문에 "durable":true가 있었으면(requested) 응답 전에 지금까지의 쓰기가 디스크에 기록될 때까지 기다리고
+// 결과를 "durable":true|false 필드로 w에 쓴다. 아니면 기다리지도 쓰지도 않는다
+static void writeDurability(JsonWriter &w, bool requested, Blockchain &blockchain)
 {
-    auto pos = body.find(key);
-    if (pos == std::string::npos)
-        return "";
-    pos += key.size();
-    auto end = body.find("\"", pos);
-    return body.substr(pos, end - pos);
+    if (requested)
+        w.field("durable", blockchain.waitDurable());
 }
 
-static UTXOTransaction parseTxJson(const std::string &body)
+enum class MiningState
 {
-    // body 예시: {"tx_id":"...","inputs":[...],"outputs":[...]}
-    std::string txId = extractQuoted(body, "\"tx_id\":\"");
-    if (txId.empty())
+    QUEUED, // 앞 작업이 끝나기를 기다린다
+    RUNNING,
+    DONE,
+    CANCELLED,
+    FAILED,
+};
+
+// /mine/status와 /mine/stream 이벤트가 보여 주는 작업 상태
+struct MiningStatus
+{
+    MiningState state = MiningState::QUEUED;
+    std::string errMsg;
+    std::string hash;
+    int nonce = 0;
+    int difficulty = 0;
+
+    bool finished() const { return state != MiningState::QUEUED && state != MiningState::RUNNING; }
+};
+
+struct MiningJob
+{
+    static constexpr size_t SAMPLE_HISTORY = 100; // 작업마다 남겨 두는 최근 샘플 수
+
+    std::string id;
+    std::string miner;
+    std::atomic<bool> cancelRequested{false}; // 채굴 중인 스레드가 배치마다 본다
+    // 아래 필드와 waiters는 mtx로 지킨다
+    MiningStatus status;
+    std::chrono::steady_clock::time_point finishedAt;
+    std::vector<StreamWake> waiters; // 새 샘플이나 상태 변화를 기다리는 /mine/stream 구독자
+    std::mutex mtx;
+
+    // 채굴 스레드만 쓰고 status/stream은 잠금 없이 읽는다
+    SampleRing samples{SAMPLE_HISTORY};
+    std::atomic<bool> waiting{false}; // waiters가 비어 있지 않다
+
+    MiningStatus currentStatus()
     {
-        txId = extractQuoted(body, "\"id\":\""); // blockchain 응답 호환
+        std::lock_guard<std::mutex> lk(mtx);
+        return status;
     }
-    std::vector<TxInput> inputs;
-    std::vector<TxOutput> outputs;
 
-    // inputs 파싱 (수동): "inputs":[{...},{...}]
-    size_t inArr = body.find("\"inputs\"");
-    if (inArr != std::string::npos)
+    // 채굴 스레드에서 샘플을 올린다. 기다리는 구독자가 없으면 잠금도 할당도 하지 않는다
+    void publish(const MiningSample &sample)
     {
-        size_t inStart = body.find("[", inArr);
-        size_t inEnd = body.find("]", inStart);
-        std::string inputsChunk = body.substr(inStart + 1, inEnd - inStart - 1);
-        size_t cursor = 0;
-        while (true)
+        samples.push(sample);
+        // waitFor의 (waiting 표시 → published 확인)과 짝을 이뤄, 둘 중 하나는 반드시 상대를 본다
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting.load(std::memory_order_relaxed))
+            wakeWaiters();
+    }
+
+    // 기다리던 구독자를 모두 깨운다 (한 번 깨우면 떨어진다). 잠금을 푼 뒤에 부른다
+    void wakeWaiters()
+    {
+        std::vector<StreamWake> taken;
         {
-            auto txPos = inputsChunk.find("\"txId\":\"", cursor);
-            if (txPos == std::string::npos)
-                break;
-            txPos += 8;
-            auto txEnd = inputsChunk.find("\"", txPos);
-            std::string refTx = inputsChunk.substr(txPos, txEnd - txPos);
-
-            auto outPos = inputsChunk.find("\"outputIndex\":", txEnd);
-            outPos += 14;
-            auto outEnd = inputsChunk.find_first_of(",}", outPos);
-            int outIdx = std::stoi(inputsChunk.substr(outPos, outEnd - outPos));
-
-            auto sigPos = inputsChunk.find("\"signature\":\"", outEnd);
-            sigPos += 13;
-            auto sigEnd = inputsChunk.find("\"", sigPos);
-            std::string sig = inputsChunk.substr(sigPos, sigEnd - sigPos);
-
-            inputs.emplace_back(refTx, outIdx, sig);
-            cursor = sigEnd;
+            std::lock_guard<std::mutex> lk(mtx);
+            taken.swap(waiters);
+            waiting.store(false, std::memory_order_relaxed);
         }
+        for (const auto &wake : taken)
+            wake();
     }
 
-    // outputs 파싱: "outputs":[{...},{...}]
-    size_t outArr = body.find("\"outputs\"");
-    if (outArr != std::string::npos)
+    // 번호 next의 샘플이나 seen과 다른 상태를 기다리도록 wake를 건다.
+    // 이미 상태가 바뀌었거나 그새 샘플이 올라왔으면 false (걸어 둔 wake는 다음 publish 때 한 번 헛되이 불릴 뿐이다)
+    bool waitFor(uint64_t next, MiningState seen, const StreamWake &wake)
     {
-        size_t oStart = body.find("[", outArr);
-        size_t oEnd = body.find("]", oStart);
-        std::string outsChunk = body.substr(oStart + 1, oEnd - oStart - 1);
-        size_t cursor = 0;
-        while (true)
         {
-            auto addrPos = outsChunk.find("\"address\":\"", cursor);
-            if (addrPos == std::string::npos)
-                break;
-            addrPos += 12;
-            auto addrEnd = outsChunk.find("\"", addrPos);
-            std::string addr = outsChunk.substr(addrPos, addrEnd - addrPos);
-
-            auto amtPos = outsChunk.find("\"amount\":", addrEnd);
-            amtPos += 9;
-            auto amtEnd = outsChunk.find_first_of(",}", amtPos);
-            double amt = std::stod(outsChunk.substr(amtPos, amtEnd - amtPos));
+            std::lock_guard<std::mutex> lk(mtx);
+            if (status.state != seen)
+                return false;
+            waiters.push_back(wake);
+            waiting.store(true, std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return samples.published() == next;
+    }
 
-            outputs.emplace_back(amt, addr);
-            cursor = amtEnd;
+    // 차례가 와서 채굴을 시작한다. 기다리는 동안 취소됐으면 false
+    bool begin()
+    {
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            if (status.state != MiningState::QUEUED)
+                return false;
+            status.state = MiningState::RUNNING;
         }
+        wakeWaiters();
+        return true;
     }
 
-    UTXOTransaction tx(txId, inputs, outputs);
-    return tx;
-}
+    // 끝난 상태로 바꾸고 기다리던 쪽을 모두 깨운다
+    void finish(MiningStatus result)
+    {
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            status = std::move(result);
+            finishedAt = std::chrono::steady_clock::now();
+        }
+        wakeWaiters();
+    }
 
-static Block parseBlockJson(const std::string &body)
-{
-    int index = std::stoi(extract(body, "\"index\":"));
-    long long ts = std::stoll(extract(body, "\"timestamp\":"));
-    int nonce = std::stoi(extract(body, "\"nonce\":"));
-    int diff = std::stoi(extract(body, "\"difficulty\":"));
-    std::string prev = extractQuoted(body, "\"previousHash\":\"");
-    std::string hash = extractQuoted(body, "\"hash\":\"");
-
-    // transactions 배열 파싱
-    std::vector<UTXOTransaction> txs;
-    size_t tArr = body.find("\"transactions\"");
-    if (tArr != std::string::npos)
-    {
-        size_t tStart = body.find("[", tArr);
-        size_t tEnd = body.find("]", tStart);
-        std::string txChunk = body.substr(tStart + 1, tEnd - tStart - 1);
-        size_t cursor = 0;
-        while (true)
+    // 취소를 요청한다. 기다리던 작업은 바로 끝내고, 채굴 중인 작업은 채굴 스레드가 다음 배치에서 멈추고 끝낸다.
+    // 이미 끝난 작업이면 false
+    bool cancel()
+    {
         {
-            auto objStart = txChunk.find("{", cursor);
-            if (objStart == std::string::npos)
-                break;
-            auto objEnd = txChunk.find("}", objStart);
-            std::string oneTxJson = txChunk.substr(objStart, objEnd - objStart + 1);
-            txs.push_back(parseTxJson(oneTxJson));
-            cursor = objEnd + 1;
+            std::lock_guard<std::mutex> lk(mtx);
+            if (status.finished())
+                return false;
+            cancelRequested.store(true);
+            if (status.state != MiningState::QUEUED)
+                return true;
+            status.state = MiningState::CANCELLED;
+            finishedAt = std::chrono::steady_clock::now();
         }
+        wakeWaiters();
+        return true;
     }
+};
 
-    Block blk(index, ts, txs, prev, nonce, diff);
-    // 신뢰 모드: 수신한 해시를 그대로 사용
-    blk.setHash(hash);
-    return blk;
-}
+std::unordered_map<std::string, std::shared_ptr<MiningJob>> jobs;
+std::mutex jobsMutex;
+
+// 채굴 작업 큐. 스레드가 하나라 한 번에 한 작업만 템플릿을 만들어 채굴하고 나머지는 들어온 순서대로 기다린다
+// (요청 워커를 오래 붙잡지 않도록 따로 둔다)
+static WorkerPool *miningJobs = nullptr;
+// 끝난 작업을 jobs에 남겨 두는 시간 (MINING_JOB_TTL 초)
+static std::chrono::seconds miningJobTTL(600);
 
-static std::string txToJson(const UTXOTransaction &tx)
+std::string makeJobId()
 {
+    auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+    std::mt19937_64 gen(now);
+    std::uniform_int_distribution<uint64_t> dist;
     std::stringstream ss;
-    ss << "{";
-    ss << "\"id\":\"" << tx.getId() << "\",";
-    ss << "\"inputs\":[";
-    const auto &inputs = tx.getInputs();
-    for (size_t i = 0; i < inputs.size(); ++i)
-    {
-        const auto &in = inputs[i];
-        ss << "{";
-        ss << "\"txId\":\"" << in.txId << "\",";
-        ss << "\"outputIndex\":" << in.outputIndex << ",";
-        ss << "\"signature\":\"" << in.signature << "\"";
-        ss << "}";
-        if (i < inputs.size() - 1)
-            ss << ",";
-    }
-    ss << "],";
-    ss << "\"outputs\":[";
-    const auto &outs = tx.getOutputs();
-    for (size_t i = 0; i < outs.size(); ++i)
-    {
-        const auto &out = outs[i];
-        ss << "{";
-        ss << "\"address\":\"" << out.address << "\",";
-        ss << "\"amount\":" << out.amount;
-        ss << "}";
-        if (i < outs.size() - 1)
-            ss << ",";
-    }
-    ss << "]";
-    ss << "}";
+    ss << std::hex << now << dist(gen);
     return ss.str();
 }
 
-static std::string blockToJson(const Block &b)
+// 채굴 큐에서 차례가 온 작업 하나를 돌린다. 다른 노드의 블록이 먼저 붙으면 minePendingTransactions가 새 팁에서 다시 시작한다
+static void runMiningJob(const std::shared_ptr<MiningJob> &job, Blockchain &blockchain)
 {
-    std::stringstream ss;
-    ss << "{";
-    ss << "\"index\":" << b.getIndex() << ",";
-    ss << "\"timestamp\":" << b.getTimestamp() << ",";
-    ss << "\"previousHash\":\"" << b.getPreviousHash() << "\",";
-    ss << "\"hash\":\"" << b.getHash() << "\",";
-    ss << "\"nonce\":" << b.getNonce() << ",";
-    ss << "\"difficulty\":" << b.getDifficulty() << ",";
-    ss << "\"transactions\":[";
-    const auto &txs = b.getTransactions();
-    for (size_t i = 0; i < txs.size(); ++i)
-    {
-        ss << txToJson(txs[i]);
-        if (i < txs.size() - 1)
-            ss << ",";
-    }
-    ss << "]";
-    ss << "}";
-    return ss.str();
+    if (!job->begin())
+        return;
+
+    MiningStatus result;
+    try
+    {
+        const Block *latest = blockchain.minePendingTransactions(job->miner, [&job](const Hash256 &h, int n)
+                                                                 { job->publish({n, h}); }, &job->cancelRequested);
+        if (latest)
+        {
+            broadcastJson("/p2p/block", toJson(*latest));
+            result.state = MiningState::DONE;
+            result.hash = latest->getHash().toHex();
+            result.nonce = latest->getNonce();
+            result.difficulty = latest->getDifficulty();
+        }
+        else
+            result.state = MiningState::CANCELLED;
+    }
+    catch (const std::exception &e)
+    {
+        result.state = MiningState::FAILED;
+        result.errMsg = e.what();
+    }
+    job->finish(std::move(result));
 }
 
-struct MiningJob
+// TTL이 지난 끝난 작업을 jobs에서 뺀다. 아직 구독 중인 스트림은 작업을 따로 붙잡고 있으므로 영향이 없다
+static void evictFinishedJobs()
 {
-    std::string id;
-    bool done = false;
-    bool error = false;
-    std::string errMsg;
-    std::string hash;
-    int nonce = 0;
-    int difficulty = 0;
-    std::vector<std::string> attempts;
-    std::mutex mtx;
-};
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(jobsMutex);
+    for (auto it = jobs.begin(); it != jobs.end();)
+    {
+        bool expired;
+        {
+            std::lock_guard<std::mutex> lk(it->second->mtx);
+            expired = it->second->status.finished() && now - it->second->finishedAt >= miningJobTTL;
+        }
+        if (expired)
+            it = jobs.erase(it);
+        else
+            ++it;
+    }
+}
 
-std::unordered_map<std::string, std::shared_ptr<MiningJob>> jobs;
-std::mutex jobsMutex;
+static std::shared_ptr<MiningJob> scheduleMining(Blockchain &blockchain, const std::string &miner)
+{
+    auto job = std::make_shared<MiningJob>();
+    job->id = makeJobId();
+    job->miner = miner;
+    job->status.difficulty = blockchain.getDifficulty();
+    evictFinishedJobs();
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        jobs[job->id] = job;
+    }
+    miningJobs->submit([job, &blockchain]()
+                       { runMiningJob(job, blockchain); });
+    return job;
+}
 
-std::string makeJobId()
+// 서버를 내릴 때 큐에 남은 작업까지 채굴하지 않도록 모두 취소한다
+static void cancelAllJobs()
 {
-    auto now = std::chrono::steady_clock::now().time_since_epoch().count();
-    std::mt19937_64 gen(now);
-    std::uniform_int_distribution<uint64_t> dist;
-    std::stringstream ss;
-    ss << std::hex << now << dist(gen);
-    return ss.str();
+    std::lock_guard<std::mutex> lock(jobsMutex);
+    for (auto &entry : jobs)
+        entry.second->cancel();
 }
 #include <string>
 
-void handleRequest(int client_socket, Blockchain &blockchain, const std::string &statePath)
+static HttpResponse buildResponse(std::string body, const std::string &contentType = "application/json")
+{
+    HttpResponse response;
+    response.contentType = contentType;
+    response.body = std::move(body);
+    response.headers.emplace_back("Access-Control-Allow-Origin", "*");
+    response.headers.emplace_back("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
+    response.headers.emplace_back("Access-Control-Allow-Headers", "Content-Type");
+    return response;
+}
+
+static std::string statusJson(std::string_view status)
+{
+    std::string out;
+    JsonWriter(out).beginObject().field("status", status).endObject();
+    return out;
+}
+
+static std::string errorJson(std::string_view message)
+{
+    std::string out;
+    JsonWriter(out).beginObject().field("status", "error").field("message", message).endObject();
+    return out;
+}
+
+static const char *miningStateName(MiningState state)
 {
-    if (client_socket < 0)
-        return; // 방어 코드
+    switch (state)
+    {
+    case MiningState::QUEUED:
+        return "queued";
+    case MiningState::RUNNING:
+        return "running";
+    case MiningState::DONE:
+        return "done";
+    case MiningState::CANCELLED:
+        return "cancelled";
+    case MiningState::FAILED:
+        break;
+    }
+    return "error";
+}
 
-    char buffer[4096] = {0};
-    ssize_t bytes_read = read(client_socket, buffer, 4096);
-    if (bytes_read <= 0)
+// /mine/status와 /mine/stream 이벤트가 같이 쓰는 채굴 작업 상태.
+// skipped는 느린 구독자가 받지 못하고 지나간 샘플 수 (0이면 쓰지 않는다)
+static void writeMiningStatus(JsonWriter &w, const MiningStatus &status, const std::vector<MiningSample> &attempts, uint64_t skipped = 0)
+{
+    w.beginObject();
+    if (status.state == MiningState::FAILED)
     {
-        close(client_socket);
+        w.field("status", "error").field("message", status.errMsg).endObject();
         return;
     }
-    std::string request(buffer, bytes_read);
-    std::istringstream iss(request);
-    std::string method, path;
-    iss >> method >> path;
+    w.field("status", miningStateName(status.state));
+    if (status.state == MiningState::DONE)
+        w.field("hash", status.hash).field("nonce", status.nonce).field("difficulty", status.difficulty);
+    if (skipped > 0)
+        w.field("skipped", skipped);
+    w.key("attempts").array(attempts).endObject();
+}
 
-    std::string response_body;
-    std::string content_type = "application/json";
+// /blockchain 응답 조각 크기. 이만큼 모이면 소켓으로 내보내고 다음 블록은 그 뒤에 직렬화한다
+constexpr size_t CHAIN_STREAM_PIECE = 64 * 1024;
 
-    // SSE stream for mining progress
-    if (path.rfind("/mine/stream", 0) == 0 && method == "GET")
+// 쿼리 문자열에서 name의 값을 찾는다 (퍼센트 디코딩은 하지 않는다)
+static bool queryParam(const std::string &target, const std::string &name, std::string &value)
+{
+    size_t q = target.find('?');
+    while (q != std::string::npos)
     {
-        size_t q = path.find("id=");
-        if (q == std::string::npos)
+        size_t begin = q + 1;
+        size_t end = target.find('&', begin);
+        std::string pair = target.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+        size_t eq = pair.find('=');
+        if (pair.substr(0, eq) == name)
         {
-            response_body = "{\"status\":\"error\",\"message\":\"job id missing\"}";
+            value = eq == std::string::npos ? "" : pair.substr(eq + 1);
+            return true;
         }
-        else
-        {
-            std::string jobId = path.substr(q + 3);
-            std::shared_ptr<MiningJob> job;
-            {
-                std::lock_guard<std::mutex> lock(jobsMutex);
-                auto it = jobs.find(jobId);
-                if (it != jobs.end())
-                    job = it->second;
-            }
+        q = end;
+    }
+    return false;
+}
 
-            if (!job)
-            {
-                response_body = "{\"status\":\"error\",\"message\":\"job not found\"}";
-            }
-            else
-            {
-                std::string headers = "HTTP/1.1 200 OK\r\n";
-                headers += "Content-Type: text/event-stream\r\n";
-                headers += "Cache-Control: no-cache\r\n";
-                headers += "Connection: keep-alive\r\n";
-                headers += "Access-Control-Allow-Origin: *\r\n";
-                headers += "Access-Control-Allow-Headers: Content-Type\r\n";
-                headers += "\r\n";
-                send(client_socket, headers.c_str(), headers.length(), 0);
-
-                size_t lastAttempt = 0;
-                while (true)
-                {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(250));
-
-                    std::vector<std::string> attempts;
-                    bool done = false;
-                    bool error = false;
-                    std::string errMsg;
-                    std::string hash;
-                    int nonce = 0;
-                    int difficulty = 0;
-
-                    {
-                        std::lock_guard<std::mutex> lk(job->mtx);
-                        attempts = job->attempts;
-                        done = job->done;
-                        error = job->error;
-                        errMsg = job->errMsg;
-                        hash = job->hash;
-                        nonce = job->nonce;
-                        difficulty = job->difficulty;
-                    }
-
-                    if (attempts.size() == lastAttempt && !done && !error)
-                        continue;
-
-                    std::stringstream payload;
-                    if (error)
-                    {
-                        payload << "{\"status\":\"error\",\"message\":\"" << errMsg << "\"}";
-                    }
-                    else
-                    {
-                        payload << "{\"status\":\"" << (done ? "done" : "running") << "\",";
-                        if (done)
-                        {
-                            payload << "\"hash\":\"" << hash << "\",";
-                            payload << "\"nonce\":" << nonce << ",";
-                            payload << "\"difficulty\":" << difficulty << ",";
-                        }
-                        payload << "\"attempts\":[";
-                        for (size_t i = 0; i < attempts.size(); ++i)
-                        {
-                            payload << "\"" << attempts[i] << "\"";
-                            if (i < attempts.size() - 1)
-                                payload << ",";
-                        }
-                        payload << "]}";
-                    }
-
-                    std::string event = "data: " + payload.str() + "\n\n";
-                    if (send(client_socket, event.c_str(), event.length(), 0) <= 0)
-                    {
-                        break;
-                    }
-
-                    lastAttempt = attempts.size();
-                    if (done || error)
-                        break;
-                }
-
-                close(client_socket);
-                return;
-            }
+// 없으면 fallback, 숫자가 아니면 false
+static bool queryHeight(const std::string &target, const std::string &name, size_t fallback, size_t &out)
+{
+    std::string value;
+    if (!queryParam(target, name, value))
+    {
+        out = fallback;
+        return true;
+    }
+    if (value.empty() || value.size() > 18 || !std::all_of(value.begin(), value.end(), [](char c)
+                                                           { return c >= '0' && c <= '9'; }))
+        return false;
+    out = (size_t)std::stoull(value);
+    return true;
+}
+
+static void appendChainBlockJson(std::string &out, const ChainStore &chain, size_t i, bool headersOnly)
+{
+    JsonWriter w(out);
+    if (headersOnly && chain.isMapped(i))
+    {
+        // 로그 레코드에서 바로 읽는다 (Block을 만들어 체인에 붙잡아 두지 않는다)
+        chain.verify(i);
+        writeBlockHeaderJson(w, chain.view(i));
+    }
+    else if (headersOnly)
+        writeBlockHeaderJson(w, chain[i]);
+    else
+        w.value(chain[i]);
+}
+
+// GET /blockchain[?from=&to=][&cursor=&limit=][&headers=1]
+// from/to는 포함 범위의 높이, cursor는 이전 응답의 nextCursor(다음에 읽을 높이)로 from 대신 쓴다.
+// 범위는 요청 시점 스냅샷의 높이 안에서 정하고, 블록은 소켓이 받는 만큼씩 직렬화해 chunked로 보낸다.
+static HttpResponse handleBlockchain(const HttpRequest &request, Blockchain &blockchain)
+{
+    auto snap = blockchain.snapshot();
+    const size_t height = snap->height;
+
+    size_t from = 0, to = 0, cursor = 0, limit = 0;
+    std::string flag;
+    const bool headersOnly = queryParam(request.target, "headers", flag) && (flag == "1" || flag == "true");
+    if (!queryHeight(request.target, "from", 0, from) || !queryHeight(request.target, "to", height - 1, to) ||
+        !queryHeight(request.target, "cursor", from, cursor) || !queryHeight(request.target, "limit", 0, limit))
+    {
+        HttpResponse response = buildResponse(errorJson("from, to, cursor and limit must be block heights"));
+        response.status = 400;
+        return response;
+    }
+
+    // [first, last) 블록을 보낸다
+    const size_t first = std::max(from, cursor);
+    size_t last = std::min(to, height - 1) + 1;
+    if (first >= last)
+        last = first;
+    const size_t pageEnd = limit > 0 && last - first > limit ? first + limit : last;
+
+    std::string tail = "],";
+    JsonWriter w(tail);
+    w.field("difficulty", snap->difficulty).field("height", height).key("nextCursor");
+    if (pageEnd < last)
+        w.value(pageEnd);
+    else
+        w.value(nullptr);
+    w.endObject();
+
+    HttpResponse response = buildResponse("");
+    const ChainStore &chain = blockchain.getChain();
+    response.stream = [&chain, first, pageEnd, headersOnly, tail = std::move(tail), next = first](std::string &out, const StreamWake &) mutable
+    {
+        if (next == first)
+            out += "{\"chain\":[";
+        while (next < pageEnd && out.size() < CHAIN_STREAM_PIECE)
+        {
+            if (next > first)
+                out += ',';
+            appendChainBlockJson(out, chain, next, headersOnly);
+            ++next;
         }
+        if (next < pageEnd)
+            return StreamStatus::MORE;
+        out += tail;
+        return StreamStatus::DONE;
+    };
+    return response;
+}
+
+// ?id=로 작업을 찾는다. 없으면 nullptr과 함께 error에 이유를 남긴다
+static std::shared_ptr<MiningJob> findJob(const std::string &target, std::string &error)
+{
+    evictFinishedJobs();
+    std::string jobId;
+    if (!queryParam(target, "id", jobId))
+    {
+        error = "job id missing";
+        return nullptr;
     }
+    std::lock_guard<std::mutex> lock(jobsMutex);
+    auto it = jobs.find(jobId);
+    if (it == jobs.end())
+    {
+        error = "job not found";
+        return nullptr;
+    }
+    return it->second;
+}
 
-    if (path == "/blockchain")
+// GET /mine/stream?id=... : 채굴 진행 상황을 SSE로 밀어 준다.
+// 구독자는 어디까지 받았는지만 들고 있고, 앞 이벤트가 소켓으로 다 나간 뒤에 그 사이 쌓인 새 샘플만 한 이벤트로 받는다.
+// 작업이 남겨 두는 최근 샘플보다 더 밀린 구독자는 그만큼 건너뛰고 "skipped"로 알린다.
+// 보낼 것이 없으면 작업의 waiters에 wake를 걸어 두고 기다린다 (구독자마다 스레드를 두지 않는다).
+// 첫 이벤트는 바로 보내고, 그 뒤로는 새 샘플이 있거나 상태(queued → running → 끝)가 바뀔 때 보낸다.
+static HttpResponse handleMiningStream(const HttpRequest &request)
+{
+    std::string error;
+    std::shared_ptr<MiningJob> job = findJob(request.target, error);
+    if (!job)
+        return buildResponse(errorJson(error));
+
+    // 남아 있는 샘플부터 보낸다
+    const uint64_t published = job->samples.published();
+    const uint64_t first = published > job->samples.capacity() ? published - job->samples.capacity() : 0;
+
+    HttpResponse response = buildResponse("", "text/event-stream");
+    response.headers.emplace_back("Cache-Control", "no-cache");
+    response.stream = [job, next = first, window = std::vector<MiningSample>(), sent = std::optional<MiningState>()](std::string &out, const StreamWake &wake) mutable
     {
-        response_body = "{\"chain\":[";
-        const auto &chain = blockchain.getChain();
-        for (size_t i = 0; i < chain.size(); i++)
+        uint64_t skipped = 0;
+        MiningStatus status;
+        for (;;)
         {
-            const auto &block = chain[i];
-            response_body += "{";
-            response_body += "\"index\":" + std::to_string(block.getIndex()) + ",";
-            response_body += "\"timestamp\":" + std::to_string(block.getTimestamp()) + ",";
-            response_body += "\"hash\":\"" + block.getHash() + "\",";
-            response_body += "\"previousHash\":\"" + block.getPreviousHash() + "\",";
-            response_body += "\"nonce\":" + std::to_string(block.getNonce()) + ",";
-            response_body += "\"difficulty\":" + std::to_string(block.getDifficulty()) + ",";
-            response_body += "\"transactions\":[";
-
-            const auto &txs = block.getTransactions();
-            for (size_t j = 0; j < txs.size(); j++)
-            {
-                const auto &tx = txs[j];
-                response_body += "{";
-                response_body += "\"id\":\"" + tx.getId() + "\",";
-                response_body += "\"inputs\":[";
-                const auto &inputs = tx.getInputs();
-                for (size_t k = 0; k < inputs.size(); ++k)
-                {
-                    const auto &in = inputs[k];
-                    response_body += "{";
-                    response_body += "\"txId\":\"" + in.txId + "\",";
-                    response_body += "\"outputIndex\":" + std::to_string(in.outputIndex) + ",";
-                    response_body += "\"signature\":\"" + in.signature + "\"";
-                    response_body += "}";
-                    if (k < inputs.size() - 1)
-                        response_body += ",";
-                }
-                response_body += "],";
-
-                response_body += "\"outputs\":[";
-                const auto &outputs = tx.getOutputs();
-                for (size_t k = 0; k < outputs.size(); ++k)
-                {
-                    const auto &out = outputs[k];
-                    response_body += "{";
-                    response_body += "\"address\":\"" + out.address + "\",";
-                    response_body += "\"amount\":" + std::to_string(out.amount);
-                    response_body += "}";
-                    if (k < outputs.size() - 1)
-                        response_body += ",";
-                }
-                response_body += "]}";
-
-                if (j < txs.size() - 1)
-                    response_body += ",";
-            }
-            response_body += "]}";
-            if (i < chain.size() - 1)
-                response_body += ",";
+            status = job->currentStatus();
+            // 상태를 먼저 보고 샘플을 읽으므로, 끝난 작업이면 마지막 샘플까지 이 이벤트에 들어간다
+            next = job->samples.read(next, window, skipped);
+            if (!window.empty() || skipped > 0 || status.state != sent)
+                break;
+            if (job->waitFor(next, status.state, wake))
+                return StreamStatus::WAIT;
         }
-        response_body += "],\"difficulty\":" + std::to_string(blockchain.getDifficulty()) + "}";
+        sent = status.state;
+
+        out += "data: ";
+        JsonWriter w(out);
+        writeMiningStatus(w, status, window, skipped);
+        out += "\n\n";
+        return status.finished() ? StreamStatus::DONE : StreamStatus::MORE;
+    };
+    return response;
+}
+
+static HttpResponse handleRequest(const HttpRequest &request, Blockchain &blockchain)
+{
+    const std::string &method = request.method;
+    const std::string &path = request.target;
+
+    std::string response_body;
+    std::string content_type = "application/json";
+
+    if (request.path() == "/blockchain")
+    {
+        return handleBlockchain(request, blockchain);
+    }
+    else if (request.path() == "/mine/stream" && method == "GET")
+    {
+        return handleMiningStream(request);
     }
     else if (path == "/difficulty")
     {
         if (method == "GET")
         {
-            response_body = "{\"difficulty\":" + std::to_string(blockchain.getDifficulty()) + "}";
+            JsonWriter(response_body).beginObject().field("difficulty", blockchain.getDifficulty()).endObject();
         }
         else if (method == "POST")
         {
-            size_t body_start = request.find("\r\n\r\n");
-            if (body_start != std::string::npos)
+            int newDiff = 0;
+            bool provided = false;
+            readBodyFields(request.body, [&](std::string_view key, JsonReader &r)
+                           {
+                if (key != "difficulty")
+                    return false;
+                newDiff = r.integer<int>();
+                provided = true;
+                return true; });
+            if (provided)
+            {
+                if (newDiff < 1)
+                    newDiff = 1;
+                blockchain.setDifficulty(newDiff);
+                JsonWriter(response_body).beginObject().field("status", "success").field("difficulty", newDiff).endObject();
+            }
+            else
             {
-                std::string body = request.substr(body_start + 4);
-                size_t diff_pos = body.find("\"difficulty\":");
-                if (diff_pos != std::string::npos)
-                {
-                    diff_pos += 13;
-                    size_t diff_end = body.find_first_of(",}", diff_pos);
-                    int newDiff = std::stoi(body.substr(diff_pos, diff_end - diff_pos));
-                    if (newDiff < 1)
-                        newDiff = 1;
-                    blockchain.setDifficulty(newDiff);
-                    response_body = "{\"status\":\"success\",\"difficulty\":" + std::to_string(newDiff) + "}";
-                }
-                else
-                {
-                    response_body = "{\"status\":\"error\",\"message\":\"difficulty not provided\"}";
-                }
+                response_body = errorJson("difficulty not provided");
             }
         }
     }
     else if (path == "/balances")
     {
-        auto balances = blockchain.getBalances();
-        response_body = "{";
-        bool first = true;
-        for (const auto &[address, balance] : balances)
-        {
-            if (!first)
-                response_body += ",";
-            response_body += "\"" + address + "\":" + std::to_string(balance);
-            first = false;
-        }
-        response_body += "}";
+        JsonWriter(response_body).value(blockchain.getBalances());
     }
     else if (path == "/utxos")
     {
-        auto utxos = blockchain.getUTXOs();
-        response_body = "[";
-        for (size_t i = 0; i < utxos.size(); ++i)
-        {
-            const auto &[txId, index, output] = utxos[i];
-            response_body += "{";
-            response_body += "\"txId\":\"" + txId + "\",";
-            response_body += "\"index\":" + std::to_string(index) + ",";
-            response_body += "\"address\":\"" + output.address + "\",";
-            response_body += "\"amount\":" + std::to_string(output.amount);
-            response_body += "}";
-            if (i < utxos.size() - 1)
-                response_body += ",";
-        }
-        response_body += "]";
+        JsonWriter(response_body).array(blockchain.getUTXOs());
     }
     else if (path == "/pending")
     {
-        const auto &pending = blockchain.getPendingTransactions();
-        response_body = "[";
-        for (size_t j = 0; j < pending.size(); ++j)
-        {
-            const auto &tx = pending[j];
-            response_body += "{";
-            response_body += "\"id\":\"" + tx.getId() + "\",";
-            response_body += "\"inputs\":[";
-            const auto &inputs = tx.getInputs();
-            for (size_t k = 0; k < inputs.size(); ++k)
-            {
-                const auto &in = inputs[k];
-                response_body += "{";
-                response_body += "\"txId\":\"" + in.txId + "\",";
-                response_body += "\"outputIndex\":" + std::to_string(in.outputIndex) + ",";
-                response_body += "\"signature\":\"" + in.signature + "\"";
-                response_body += "}";
-                if (k < inputs.size() - 1)
-                    response_body += ",";
-            }
-            response_body += "],";
-
-            response_body += "\"outputs\":[";
-            const auto &outputs = tx.getOutputs();
-            for (size_t k = 0; k < outputs.size(); ++k)
-            {
-                const auto &out = outputs[k];
-                response_body += "{";
-                response_body += "\"address\":\"" + out.address + "\",";
-                response_body += "\"amount\":" + std::to_string(out.amount);
-                response_body += "}";
-                if (k < outputs.size() - 1)
-                    response_body += ",";
-            }
-            response_body += "]}";
-            if (j < pending.size() - 1)
-                response_body += ",";
-        }
-        response_body += "]";
+        auto snap = blockchain.snapshot();
+        JsonWriter w(response_body);
+        w.beginArray();
+        for (size_t j = 0; j < snap->pendingCount; ++j)
+            w.value(snap->pending(j));
+        w.endArray();
     }
     else if (path == "/p2p/tx" && method == "POST")
     {
-        size_t body_start = request.find("\r\n\r\n");
-        if (body_start != std::string::npos)
+        const std::string &body = request.body;
+        try
         {
-            std::string body = request.substr(body_start + 4);
-            try
-            {
-                UTXOTransaction tx = parseTxJson(body);
-                bool duplicate = false;
-                for (const auto &p : blockchain.getPendingTransactions())
-                {
-                    if (p.getId() == tx.getId())
-                    {
-                        duplicate = true;
-                        break;
-                    }
-                }
-                if (!duplicate)
-                {
-                    blockchain.addExternalPending(tx);
-                }
-                response_body = "{\"status\":\"ok\"}";
-            }
-            catch (const std::exception &e)
-            {
-                response_body = std::string("{\"status\":\"error\",\"message\":\"") + e.what() + "\"}";
-            }
+            UTXOTransaction tx = parseTransactionJson(body);
+            blockchain.addExternalPending(tx); // 이미 있으면 무시된다
+            response_body = statusJson("ok");
+        }
+        catch (const std::exception &e)
+        {
+            response_body = errorJson(e.what());
         }
     }
     else if (path == "/p2p/block" && method == "POST")
     {
-        size_t body_start = request.find("\r\n\r\n");
-        if (body_start != std::string::npos)
+        const std::string &body = request.body;
+        try
         {
-            std::string body = request.substr(body_start + 4);
-            try
+            bool durable = false;
+            Block b = parseBlockJson(body, [&durable](std::string_view key, JsonReader &r)
+                                     {
+                if (key != "durable")
+                    return false;
+                durable = r.boolean();
+                return true; });
+            if (blockchain.acceptExternalBlock(b))
             {
-                Block b = parseBlockJson(body);
-                if (blockchain.acceptExternalBlock(b))
-                {
-                    response_body = "{\"status\":\"ok\"}";
-                }
-                else
-                {
-                    response_body = "{\"status\":\"error\",\"message\":\"reject\"}";
-                }
+                JsonWriter w(response_body);
+                w.beginObject().field("status", "ok");
+                writeDurability(w, durable, blockchain);
+                w.endObject();
             }
-            catch (const std::exception &e)
+            else
             {
-                response_body = std::string("{\"status\":\"error\",\"message\":\"") + e.what() + "\"}";
+                response_body = errorJson("reject");
             }
         }
+        catch (const std::exception &e)
+        {
+            response_body = errorJson(e.what());
+        }
     }
     else if (path == "/transaction" && method == "POST")
     {
-        size_t body_start = request.find("\r\n\r\n");
-        if (body_start != std::string::npos)
-        {
-            std::string body = request.substr(body_start + 4);
-
-            size_t sender_pos = body.find("\"sender\":\"") + 10;
-            size_t sender_end = body.find("\"", sender_pos);
-            std::string sender = body.substr(sender_pos, sender_end - sender_pos);
-
-            size_t recipient_pos = body.find("\"recipient\":\"") + 13;
-            size_t recipient_end = body.find("\"", recipient_pos);
-            std::string recipient = body.substr(recipient_pos, recipient_end - recipient_pos);
-
-            size_t amount_pos = body.find("\"amount\":") + 9;
-            size_t amount_end = body.find_first_of(",}", amount_pos);
-            double amount = std::stod(body.substr(amount_pos, amount_end - amount_pos));
-
-            std::string error;
-            bool ok = blockchain.addTransaction(sender, recipient, amount, error);
-            if (ok)
+        std::string sender, recipient;
+        double amount = 0.0;
+        bool hasAmount = false, durable = false;
+        readBodyFields(request.body, [&](std::string_view key, JsonReader &r)
+                       {
+            if (key == "sender")
+                sender = r.string();
+            else if (key == "recipient")
+                recipient = r.string();
+            else if (key == "amount")
             {
-                response_body = "{\"status\":\"success\"}";
-                const auto &pending = blockchain.getPendingTransactions();
-                if (!pending.empty())
-                {
-                    const auto &lastTx = pending.back();
-                    broadcastJson("/p2p/tx", txToJson(lastTx));
-                }
+                amount = r.number();
+                hasAmount = true;
             }
+            else if (key == "durable")
+                durable = r.boolean();
             else
-            {
-                response_body = "{\"status\":\"error\",\"message\":\"" + error + "\"}";
-            }
-        }
-    }
-    else if (path == "/mine" && method == "POST")
-    {
-        // legacy synchronous mining kept for compatibility
-        std::string miner = "default_miner";
-        size_t body_start = request.find("\r\n\r\n");
-        if (body_start != std::string::npos)
+                return false;
+            return true; });
+        if (sender.empty() || recipient.empty() || !hasAmount)
+            return buildResponse(errorJson("sender, recipient and amount are required"));
+
+        std::string error;
+        std::optional<UTXOTransaction> created;
+        bool ok = blockchain.addTransaction(sender, recipient, amount, error, &created);
+        if (ok)
         {
-            std::string body = request.substr(body_start + 4);
-            size_t miner_pos = body.find("\"miner\":\"");
-            if (miner_pos != std::string::npos)
-            {
-                miner_pos += 9;
-                size_t miner_end = body.find("\"", miner_pos);
-                miner = body.substr(miner_pos, miner_end - miner_pos);
-            }
+            JsonWriter w(response_body);
+            w.beginObject().field("status", "success");
+            writeDurability(w, durable, blockchain);
+            w.endObject();
+            broadcastJson("/p2p/tx", toJson(*created));
         }
-
-        std::vector<std::string> attempts;
-        blockchain.minePendingTransactions(miner, [&](const std::string &h, int n)
-                                           {
-            attempts.push_back(std::to_string(n) + ":" + h);
-            if (attempts.size() > 50)
-                attempts.erase(attempts.begin()); });
-        blockchain.saveToFile(statePath);
-
-        const Block &latest = blockchain.getLatestBlock();
-        broadcastJson("/p2p/block", blockToJson(latest));
-        response_body = "{";
-        response_body += "\"status\":\"success\",";
-        response_body += "\"hash\":\"" + latest.getHash() + "\",";
-        response_body += "\"nonce\":" + std::to_string(latest.getNonce()) + ",";
-        response_body += "\"difficulty\":" + std::to_string(latest.getDifficulty()) + ",";
-        response_body += "\"attempts\":[";
-        for (size_t i = 0; i < attempts.size(); ++i)
+        else
         {
-            response_body += "\"" + attempts[i] + "\"";
-            if (i < attempts.size() - 1)
-                response_body += ",";
+            response_body = errorJson(error);
         }
-        response_body += "]";
-        response_body += "}";
     }
-    else if (path == "/mine/start" && method == "POST")
+    else if ((path == "/mine/start" || path == "/mine") && method == "POST")
     {
-        size_t body_start = request.find("\r\n\r\n");
+        // /mine은 예전에 끝날 때까지 응답을 붙잡았지만, 그동안 요청 워커가 막히므로 이제 /mine/start와 같다
         std::string miner = "default_miner";
-
-        if (body_start != std::string::npos)
-        {
-            std::string body = request.substr(body_start + 4);
-            size_t miner_pos = body.find("\"miner\":\"");
-            if (miner_pos != std::string::npos)
-            {
-                miner_pos += 9;
-                size_t miner_end = body.find("\"", miner_pos);
-                miner = body.substr(miner_pos, miner_end - miner_pos);
-            }
-        }
-
-        auto job = std::make_shared<MiningJob>();
-        job->id = makeJobId();
-        job->difficulty = blockchain.getDifficulty();
-
-        {
-            std::lock_guard<std::mutex> lock(jobsMutex);
-            jobs[job->id] = job;
-        }
-
-        std::thread([job, miner, statePath, &blockchain]()
-                    {
-            try
-            {
-                blockchain.minePendingTransactions(miner, [job](const std::string &h, int n) {
-                    std::lock_guard<std::mutex> lk(job->mtx);
-                    job->attempts.push_back(std::to_string(n) + ":" + h);
-                    if (job->attempts.size() > 100)
-                        job->attempts.erase(job->attempts.begin());
-                });
-                blockchain.saveToFile(statePath);
-
-                const Block &latest = blockchain.getLatestBlock();
-                broadcastJson("/p2p/block", blockToJson(latest));
-                std::lock_guard<std::mutex> lk(job->mtx);
-                job->done = true;
-                job->hash = latest.getHash();
-                job->nonce = latest.getNonce();
-                job->difficulty = latest.getDifficulty();
-            }
-            catch (const std::exception &e)
-            {
-                std::lock_guard<std::mutex> lk(job->mtx);
-                job->error = true;
-                job->errMsg = e.what();
-            } })
-            .detach();
-
-        response_body = "{\"status\":\"started\",\"jobId\":\"" + job->id + "\"}";
+        readBodyFields(request.body, [&miner](std::string_view key, JsonReader &r)
+                       {
+            if (key != "miner")
+                return false;
+            miner = r.string();
+            return true; });
+
+        // 앞 작업이 있으면 큐에서 기다린다 ("status":"queued")
+        std::shared_ptr<MiningJob> job = scheduleMining(blockchain, miner);
+        JsonWriter(response_body).beginObject().field("status", "started").field("jobId", job->id).endObject();
     }
     else if (path.rfind("/mine/status", 0) == 0 && method == "GET")
     {
-        size_t q = path.find("id=");
-        if (q == std::string::npos)
+        std::string error;
+        std::shared_ptr<MiningJob> job = findJob(path, error);
+        if (!job)
         {
-            response_body = "{\"status\":\"error\",\"message\":\"job id missing\"}";
+            response_body = errorJson(error);
         }
         else
         {
-            std::string jobId = path.substr(q + 3);
-            std::shared_ptr<MiningJob> job;
-            {
-                std::lock_guard<std::mutex> lock(jobsMutex);
-                auto it = jobs.find(jobId);
-                if (it != jobs.end())
-                    job = it->second;
-            }
-
-            if (!job)
-            {
-                response_body = "{\"status\":\"error\",\"message\":\"job not found\"}";
-            }
-            else
-            {
-                std::lock_guard<std::mutex> lk(job->mtx);
-                response_body = "{";
-                if (job->error)
-                {
-                    response_body += "\"status\":\"error\",\"message\":\"" + job->errMsg + "\"";
-                }
-                else if (job->done)
-                {
-                    response_body += "\"status\":\"done\",";
-                    response_body += "\"hash\":\"" + job->hash + "\",";
-                    response_body += "\"nonce\":" + std::to_string(job->nonce) + ",";
-                    response_body += "\"difficulty\":" + std::to_string(job->difficulty) + ",";
-                    response_body += "\"attempts\":[";
-                    for (size_t i = 0; i < job->attempts.size(); ++i)
-                    {
-                        response_body += "\"" + job->attempts[i] + "\"";
-                        if (i < job->attempts.size() - 1)
-                            response_body += ",";
-                    }
-                    response_body += "]";
-                }
-                else
-                {
-                    response_body += "\"status\":\"running\",";
-                    response_body += "\"attempts\":[";
-                    for (size_t i = 0; i < job->attempts.size(); ++i)
-                    {
-                        response_body += "\"" + job->attempts[i] + "\"";
-                        if (i < job->attempts.size() - 1)
-                            response_body += ",";
-                    }
-                    response_body += "]";
-                }
-                response_body += "}";
-            }
+            const MiningStatus status = job->currentStatus();
+            std::vector<MiningSample> attempts;
+            uint64_t skipped = 0;
+            job->samples.read(0, attempts, skipped); // 남아 있는 샘플 전부. 앞에서 밀려난 것은 세지 않는다
+            JsonWriter w(response_body);
+            writeMiningStatus(w, status, attempts);
         }
     }
+    else if (path.rfind("/mine/cancel", 0) == 0 && method == "POST")
+    {
+        // 기다리던 작업은 바로 "cancelled", 채굴 중인 작업은 다음 배치에서 멈추므로 "cancelling"
+        std::string error;
+        std::shared_ptr<MiningJob> job = findJob(path, error);
+        if (!job)
+            response_body = errorJson(error);
+        else if (!job->cancel())
+            response_body = errorJson("job already finished");
+        else
+            response_body = statusJson(job->currentStatus().finished() ? "cancelled" : "cancelling");
+    }
     else
     {
         response_body = "{\"error\":\"Not found\"}";
     }
 
-    std::string response = "HTTP/1.1 200 OK\r\n";
-    response += "Content-Type: " + content_type + "\r\n";
-    response += "Content-Length: " + std::to_string(response_body.length()) + "\r\n";
-    response += "Access-Control-Allow-Origin: *\r\n";
-    response += "Access-Control-Allow-Methods: GET, POST, OPTIONS\r\n";
-    response += "Access-Control-Allow-Headers: Content-Type\r\n";
-    response += "\r\n";
-    response += response_body;
+    return buildResponse(std::move(response_body), content_type);
+}
 
-    send(client_socket, response.c_str(), response.length(), 0);
-    close(client_socket);
+// 조회는 이벤트 루프에서 바로, 상태를 바꾸거나 오래 걸리는 요청(채굴, 블록 검증, 피어 전파)과
+// UTXO 전체를 직렬화하는 요청은 워커에서 처리한다. /blockchain은 루프가 소켓이 비는 대로 조각씩 만들고,
+// /mine/stream은 새 샘플이 올라올 때마다 루프가 이벤트를 만든다
+static HttpServer::Dispatch classifyRequest(const HttpRequest &request)
+{
+    const std::string path = request.path();
+    if (request.method == "POST")
+        return HttpServer::Dispatch::WORKER;
+    if (path == "/utxos")
+        return HttpServer::Dispatch::WORKER;
+    return HttpServer::Dispatch::INLINE;
 }
 
-void runServer(Blockchain &blockchain, const std::string &statePath)
+static size_t envPositive(const char *name, size_t fallback)
 {
-    int server_fd = socket(AF_INET, SOCK_STREAM, 0);
-    int opt = 1;
-    setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    const char *value = std::getenv(name);
+    if (value)
+    {
+        long long n = std::atoll(value);
+        if (n > 0)
+            return (size_t)n;
+    }
+    return fallback;
+}
 
-    struct sockaddr_in address;
-    address.sin_family = AF_INET;
-    address.sin_addr.s_addr = INADDR_ANY;
+void runServer(Blockchain &blockchain)
+{
     int port = 8080;
     const char *envPort = std::getenv("PORT");
     if (envPort)
     {
         port = std::atoi(envPort);
     }
-    address.sin_port = htons(port);
 
-    if (bind(server_fd, (struct sockaddr *)&address, sizeof(address)) < 0)
-    {
-        std::cerr << "Bind failed\n";
-        return;
-    }
-    if (listen(server_fd, 3) < 0)
-    {
-        std::cerr << "Listen failed\n";
-        return;
-    }
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    const unsigned loopCount = (unsigned)envPositive("SERVER_THREADS", cores);
+    WorkerPool workers((unsigned)envPositive("WORKER_THREADS", std::max(2u, cores)));
+    WorkerPool mining(1);
+    miningJobs = &mining;
+    miningJobTTL = std::chrono::seconds(envPositive("MINING_JOB_TTL", (size_t)miningJobTTL.count()));
 
-    std::cout << "Server listening on port " << port << "...\n";
     initPeersFromEnv();
 
-    while (true)
+    HttpServer::Routes routes;
+    routes.classify = classifyRequest;
+    routes.handle = [&blockchain](const HttpRequest &request)
     {
-        int client_socket = accept(server_fd, nullptr, nullptr);
-        if (client_socket < 0)
+        try
         {
-            std::cerr << "Accept failed\n";
-            continue;
+            return handleRequest(request, blockchain);
         }
-        std::thread([client_socket, &blockchain, statePath]()
-                    { handleRequest(client_socket, blockchain, statePath); })
-            .detach();
-    }
+        catch (const JsonError &e)
+        {
+            HttpResponse response = buildResponse(errorJson(e.what()));
+            response.status = 400;
+            return response;
+        }
+    };
+
+    HttpLimits limits;
+    limits.maxHeaderBytes = envPositive("HTTP_MAX_HEADER_BYTES", limits.maxHeaderBytes);
+    limits.maxBodyBytes = envPositive("HTTP_MAX_BODY_BYTES", limits.maxBodyBytes);
+    limits.idleTimeoutSeconds = (int)envPositive("HTTP_IDLE_TIMEOUT", (size_t)limits.idleTimeoutSeconds);
+
+    HttpServer server(std::move(routes), workers, limits);
+    if (!server.run(port, loopCount))
+        std::cerr << "❌ Failed to start HTTP server on port " << port << "\n";
+
+    // 루프가 멈췄으니 새 요청은 없다. 처리 중인 요청이 마저 끝나야 작업을 더 만들지 않는다
+    workers.shutdown();
+    // 기다리던 작업은 바로, 채굴 중인 작업은 다음 배치에서 끝난다. 스트림 wake가 루프를 부르므로 server보다 먼저 비운다
+    cancelAllJobs();
+    mining.shutdown();
+    miningJobs = nullptr;
 }
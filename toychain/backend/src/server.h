@@ -4,6 +4,6 @@
 #include "blockchain.h"
 #include <string>
 
-void runServer(Blockchain &blockchain, const std::string &statePath);
+void runServer(Blockchain &blockchain);
 
 #endif
@@ -0,0 +1,163 @@
+#include "snapshot.h"
+#include "byte_io.h"
+#include "storage.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+    const char SNAPSHOT_MAGIC[8] = {'T', 'C', 'U', 'T', 'X', 'O', '\0', '\0'};
+    constexpr uint32_t SNAPSHOT_VERSION = 1;
+    constexpr size_t SNAPSHOT_HEADER_SIZE = sizeof(SNAPSHOT_MAGIC) + 4 + 8 + Sha256::DIGEST_SIZE;
+}
+
+UTXOSnapshotter::UTXOSnapshotter(const std::string &path)
+    : path(path), worker(&UTXOSnapshotter::run, this)
+{
+}
+
+UTXOSnapshotter::~UTXOSnapshotter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    cv.notify_all();
+    worker.join();
+}
+
+void UTXOSnapshotter::schedule(std::shared_ptr<const UTXOSet> frozen, uint64_t height, const Hash256 &tip)
+{
+    auto job = std::make_unique<Job>(Job{std::move(frozen), height, tip});
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        pending = std::move(job);
+    }
+    cv.notify_all();
+}
+
+void UTXOSnapshotter::flush()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    cv.wait(lock, [this]
+            { return !pending && !busy; });
+}
+
+void UTXOSnapshotter::run()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true)
+    {
+        cv.wait(lock, [this]
+                { return pending || stopping; });
+        if (!pending)
+            return; // stopping, 남은 예약 없음
+
+        std::unique_ptr<Job> job = std::move(pending);
+        busy = true;
+        lock.unlock();
+
+        if (write(path, *job->set, job->height, job->tip))
+            std::cout << "💾 UTXO snapshot written at height " << job->height << "\n";
+        job.reset();
+
+        lock.lock();
+        busy = false;
+        cv.notify_all();
+    }
+}
+
+bool UTXOSnapshotter::write(const std::string &path, const UTXOSet &set, uint64_t height, const Hash256 &tip)
+{
+    std::string data(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    putLE32(data, SNAPSHOT_VERSION);
+    putLE64(data, height);
+    data.append(reinterpret_cast<const char *>(tip.data()), Sha256::DIGEST_SIZE);
+    set.serialize(data);
+    putLE32(data, computeCrc32(data.data(), data.size()));
+
+    const std::string tmpPath = path + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        std::cerr << "❌ Cannot open " << tmpPath << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    const char *p = data.data();
+    size_t left = data.size();
+    bool ok = true;
+    while (left > 0)
+    {
+        ssize_t n = ::write(fd, p, left);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            ok = false;
+            break;
+        }
+        p += n;
+        left -= static_cast<size_t>(n);
+    }
+    ok = ok && ::fsync(fd) == 0;
+    ::close(fd);
+
+    if (!ok || std::rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+        std::cerr << "❌ UTXO snapshot write failed: " << std::strerror(errno) << std::endl;
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool UTXOSnapshotter::load(UTXOSet &out, uint64_t &height, Hash256 &tip) const
+{
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in.is_open())
+        return false;
+    std::string data(static_cast<size_t>(in.tellg()), '\0');
+    in.seekg(0);
+    if (!in.read(&data[0], static_cast<std::streamsize>(data.size())))
+        return false;
+
+    const unsigned char *base = reinterpret_cast<const unsigned char *>(data.data());
+    if (data.size() < SNAPSHOT_HEADER_SIZE + 4 || std::memcmp(base, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0)
+    {
+        std::cerr << "⚠️ Ignoring " << path << ": not a UTXO snapshot\n";
+        return false;
+    }
+    const size_t bodyEnd = data.size() - 4;
+    if (computeCrc32(base, bodyEnd) != loadLE32(base + bodyEnd))
+    {
+        std::cerr << "⚠️ Ignoring " << path << ": checksum mismatch\n";
+        return false;
+    }
+    if (loadLE32(base + sizeof(SNAPSHOT_MAGIC)) != SNAPSHOT_VERSION)
+    {
+        std::cerr << "⚠️ Ignoring " << path << ": unsupported version\n";
+        return false;
+    }
+
+    UTXOSet loaded;
+    try
+    {
+        loaded.deserialize(base + SNAPSHOT_HEADER_SIZE, bodyEnd - SNAPSHOT_HEADER_SIZE);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "⚠️ Ignoring " << path << ": " << e.what() << "\n";
+        return false;
+    }
+
+    height = loadLE64(base + sizeof(SNAPSHOT_MAGIC) + 4);
+    std::memcpy(tip.data(), base + sizeof(SNAPSHOT_MAGIC) + 12, Sha256::DIGEST_SIZE);
+    out = std::move(loaded);
+    return true;
+}
@@ -0,0 +1,61 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "crypto.h"
+#include "utxo.h"
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// UTXO 집합 스냅샷 (utxo.snapshot)
+//
+// 파일 구조 (little-endian):
+//   "TCUTXO\0\0" magic | uint32 version | uint64 height | tip hash 32바이트 | UTXOSet::serialize | uint32 crc32
+// height는 스냅샷에 반영된 블록 수, tip은 그 마지막 블록의 해시다.
+// 시작할 때 스냅샷을 읽고 tip이 체인과 맞으면 그 뒤 블록만 다시 적용한다.
+//
+// 쓰기는 전용 스레드가 한다. schedule()은 더 바뀌지 않는 UTXOSet 버전(체인이 발행한 것)을 넘기고 바로 돌아오며,
+// 아직 시작하지 않은 예약이 있으면 새 것으로 바꾼다. 파일은 임시 파일에 쓴 뒤 rename으로 교체한다.
+class UTXOSnapshotter
+{
+public:
+    explicit UTXOSnapshotter(const std::string &path);
+    ~UTXOSnapshotter();
+
+    UTXOSnapshotter(const UTXOSnapshotter &) = delete;
+    UTXOSnapshotter &operator=(const UTXOSnapshotter &) = delete;
+
+    void schedule(std::shared_ptr<const UTXOSet> frozen, uint64_t height, const Hash256 &tip);
+    // 예약된 스냅샷이 모두 기록될 때까지 기다린다
+    void flush();
+
+    // 스냅샷이 없거나 손상되었으면 false (out은 건드리지 않는다)
+    bool load(UTXOSet &out, uint64_t &height, Hash256 &tip) const;
+
+    const std::string &getPath() const { return path; }
+
+    static bool write(const std::string &path, const UTXOSet &set, uint64_t height, const Hash256 &tip);
+
+private:
+    struct Job
+    {
+        std::shared_ptr<const UTXOSet> set;
+        uint64_t height;
+        Hash256 tip;
+    };
+
+    std::string path;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::unique_ptr<Job> pending;
+    bool busy = false;
+    bool stopping = false;
+    std::thread worker;
+
+    void run();
+};
+
+#endif
@@ -0,0 +1,404 @@
+#include "storage.h"
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    const char LOG_MAGIC[8] = {'T', 'C', 'B', 'L', 'O', 'C', 'K', '\0'};
+    constexpr uint32_t LOG_VERSION = 1;
+    constexpr size_t LOG_HEADER_SIZE = sizeof(LOG_MAGIC) + 4;
+    constexpr size_t RECORD_PREFIX = 8;                // length + crc
+    constexpr uint32_t MAX_RECORD_SIZE = 256u << 20;   // 이보다 큰 length는 손상으로 본다
+
+    void putHash(std::string &out, const Hash256 &h)
+    {
+        out.append(reinterpret_cast<const char *>(h.data()), Sha256::DIGEST_SIZE);
+    }
+
+    void putString(std::string &out, const std::string &s)
+    {
+        putLE32(out, static_cast<uint32_t>(s.size()));
+        out.append(s);
+    }
+
+    bool writeAll(int fd, const char *data, size_t len)
+    {
+        while (len > 0)
+        {
+            ssize_t n = ::write(fd, data, len);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            data += n;
+            len -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    int syncFd(int fd)
+    {
+#if defined(__linux__)
+        return ::fdatasync(fd);
+#else
+        return ::fsync(fd);
+#endif
+    }
+}
+
+uint32_t computeCrc32(const void *data, size_t len, uint32_t crc)
+{
+    // IEEE 802.3 다항식 (zlib crc32와 같은 값), slicing-by-8: 8바이트씩 테이블 8개로 처리
+    static const auto table = []
+    {
+        std::array<std::array<uint32_t, 256>, 8> t{};
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; ++i)
+            for (int k = 1; k < 8; ++k)
+                t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+        return t;
+    }();
+
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    crc = ~crc;
+    while (len >= 8)
+    {
+        uint32_t lo = loadLE32(p) ^ crc;
+        uint32_t hi = loadLE32(p + 4);
+        crc = table[7][lo & 0xFF] ^ table[6][(lo >> 8) & 0xFF] ^ table[5][(lo >> 16) & 0xFF] ^ table[4][lo >> 24] ^
+              table[3][hi & 0xFF] ^ table[2][(hi >> 8) & 0xFF] ^ table[1][(hi >> 16) & 0xFF] ^ table[0][hi >> 24];
+        p += 8;
+        len -= 8;
+    }
+    while (len-- > 0)
+        crc = table[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+BlockLog::BlockLog(const std::string &path, unsigned syncEvery)
+    : path(path), syncEvery(syncEvery)
+{
+}
+
+BlockLog::~BlockLog()
+{
+    if (fd >= 0)
+    {
+        syncLocked();
+        ::close(fd);
+    }
+    if (syncedFd >= 0)
+        ::close(syncedFd);
+}
+
+size_t BlockLog::readSyncedLength()
+{
+    unsigned char buf[12];
+    if (syncedFd < 0 || ::pread(syncedFd, buf, sizeof(buf), 0) != (ssize_t)sizeof(buf))
+        return 0;
+    if (computeCrc32(buf, 8) != loadLE32(buf + 8))
+        return 0;
+    return static_cast<size_t>(loadLE64(buf));
+}
+
+void BlockLog::writeSyncedLength(size_t length)
+{
+    if (syncedFd < 0)
+        return;
+    // 옆 파일은 fsync하지 않는다. 내려가지 못하면 다음 시작 때 더 많이 확인할 뿐이다
+    std::string buf;
+    putLE64(buf, static_cast<uint64_t>(length));
+    putLE32(buf, computeCrc32(buf.data(), buf.size()));
+    if (::pwrite(syncedFd, buf.data(), buf.size(), 0) != (ssize_t)buf.size())
+        std::cerr << "⚠️ Cannot record synced length of block log " << path << ": " << std::strerror(errno) << std::endl;
+}
+
+bool BlockLog::load(MappedBlocks &blocks, int &difficulty)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    blocks = MappedBlocks();
+    blockCount = 0;
+
+    if (fd < 0)
+    {
+        try
+        {
+            auto dir = std::filesystem::path(path).parent_path();
+            if (!dir.empty())
+                std::filesystem::create_directories(dir);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "❌ Cannot create block log directory: " << e.what() << std::endl;
+        }
+
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+        if (fd < 0)
+        {
+            std::cerr << "❌ Cannot open block log " << path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        syncedFd = ::open((path + ".synced").c_str(), O_RDWR | O_CREAT, 0644);
+        if (syncedFd < 0)
+            std::cerr << "⚠️ Cannot open " << path << ".synced, the whole log will be checked on every start: "
+                      << std::strerror(errno) << std::endl;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+        std::cerr << "❌ Cannot stat block log " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    const size_t fileSize = static_cast<size_t>(st.st_size);
+
+    if (fileSize == 0)
+    {
+        std::string header(LOG_MAGIC, sizeof(LOG_MAGIC));
+        putLE32(header, LOG_VERSION);
+        if (!writeAll(fd, header.data(), header.size()) || syncFd(fd) != 0)
+        {
+            std::cerr << "❌ Cannot initialize block log " << path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        // 지워진 예전 로그의 길이가 남아 있으면 안 된다
+        fileLength = header.size();
+        writeSyncedLength(fileLength);
+        return true;
+    }
+
+    auto file = MappedFile::map(fd, fileSize);
+    if (!file)
+    {
+        std::cerr << "❌ Cannot mmap block log " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    const unsigned char *base = file->data();
+    if (fileSize < LOG_HEADER_SIZE || std::memcmp(base, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0)
+    {
+        std::cerr << "❌ " << path << " is not a block log\n";
+        return false;
+    }
+    if (loadLE32(base + sizeof(LOG_MAGIC)) != LOG_VERSION)
+    {
+        std::cerr << "❌ Unsupported block log version in " << path << "\n";
+        return false;
+    }
+
+    // 1) length prefix만 따라가며 레코드 위치를 모은다 (payload는 건드리지 않는다)
+    struct RecordRef
+    {
+        size_t offset;
+        uint32_t length;
+    };
+    std::vector<RecordRef> records;
+    size_t offset = LOG_HEADER_SIZE;
+    while (fileSize - offset >= RECORD_PREFIX + 1)
+    {
+        const uint32_t length = loadLE32(base + offset);
+        if (length == 0 || length > MAX_RECORD_SIZE || fileSize - offset - RECORD_PREFIX < length)
+            break;
+        records.push_back({offset, length});
+        offset += RECORD_PREFIX + length;
+    }
+
+    // 2) fsync가 끝났다고 기록된 길이 뒤의 레코드는 CRC를 확인해, 쓰다 만 레코드가 있으면 그 앞에서 자른다.
+    //    기록이 없거나 파일보다 길면(다른 로그의 값) 전부 확인한다
+    size_t synced = readSyncedLength();
+    if (synced > fileSize)
+        synced = 0;
+    size_t validRecords = records.size();
+    size_t checkFrom = 0;
+    while (checkFrom < records.size() && records[checkFrom].offset + RECORD_PREFIX + records[checkFrom].length <= synced)
+        ++checkFrom;
+    for (size_t i = checkFrom; i < records.size(); ++i)
+    {
+        const unsigned char *record = base + records[i].offset;
+        if (computeCrc32(record + RECORD_PREFIX, records[i].length) != loadLE32(record + 4))
+        {
+            validRecords = i;
+            break;
+        }
+    }
+    size_t validEnd = validRecords < records.size() ? records[validRecords].offset : offset;
+
+    // 3) 블록 위치와 난이도
+    for (size_t i = 0; i < validRecords; ++i)
+    {
+        const unsigned char *record = base + records[i].offset;
+        switch (record[RECORD_PREFIX])
+        {
+        case RECORD_BLOCK:
+            if (records[i].length - 1 < BlockView::HEADER_SIZE)
+            {
+                std::cerr << "❌ Corrupted block log " << path << " at offset " << records[i].offset << ": short block record\n";
+                return false;
+            }
+            blocks.offsets.push_back(records[i].offset);
+            break;
+        case RECORD_DIFFICULTY:
+            if (records[i].length - 1 < 4)
+            {
+                std::cerr << "❌ Corrupted block log " << path << " at offset " << records[i].offset << ": short difficulty record\n";
+                return false;
+            }
+            difficulty = static_cast<int32_t>(loadLE32(record + RECORD_PREFIX + 1));
+            break;
+        default:
+            std::cerr << "❌ Corrupted block log " << path << " at offset " << records[i].offset << ": unknown record type "
+                      << static_cast<int>(record[RECORD_PREFIX]) << "\n";
+            return false;
+        }
+    }
+
+    if (validEnd != fileSize)
+    {
+        // 마지막 append가 끝나기 전에 멈춘 경우: 온전한 레코드까지만 남긴다.
+        // 매핑은 그대로 두지만 잘린 뒤쪽은 다시 읽지 않는다.
+        std::cerr << "⚠️ Discarding " << (fileSize - validEnd) << " bytes of incomplete block log tail\n";
+        if (::ftruncate(fd, static_cast<off_t>(validEnd)) != 0 || syncFd(fd) != 0)
+        {
+            std::cerr << "❌ Cannot truncate block log " << path << ": " << std::strerror(errno) << std::endl;
+            blocks = MappedBlocks();
+            return false;
+        }
+    }
+
+    // 확인한 내용이 디스크에 있는 것과 같도록 내린 뒤, 다음 시작 때는 이 뒤만 확인하게 한다
+    if (validEnd > synced && validEnd == fileSize && syncFd(fd) != 0)
+    {
+        std::cerr << "❌ Block log fsync failed: " << std::strerror(errno) << std::endl;
+        blocks = MappedBlocks();
+        return false;
+    }
+    fileLength = validEnd;
+    if (validEnd != synced)
+        writeSyncedLength(validEnd);
+
+    blocks.file = std::move(file);
+    blockCount = blocks.offsets.size();
+    return true;
+}
+
+bool BlockLog::appendBlock(const Block &block)
+{
+    std::string payload;
+    encodeBlock(block, payload);
+
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!appendRecord(RECORD_BLOCK, payload))
+        return false;
+    ++blockCount;
+    return true;
+}
+
+bool BlockLog::appendDifficulty(int difficulty)
+{
+    std::string payload;
+    putLE32(payload, static_cast<uint32_t>(difficulty));
+
+    std::lock_guard<std::mutex> lock(mtx);
+    return appendRecord(RECORD_DIFFICULTY, payload);
+}
+
+bool BlockLog::sync()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return syncLocked();
+}
+
+bool BlockLog::appendRecord(RecordType type, const std::string &payload)
+{
+    if (fd < 0)
+        return false;
+
+    std::string record;
+    record.reserve(RECORD_PREFIX + 1 + payload.size());
+    putLE32(record, static_cast<uint32_t>(payload.size() + 1));
+    putLE32(record, 0); // crc 자리
+    record.push_back(static_cast<char>(type));
+    record.append(payload);
+
+    uint32_t crc = computeCrc32(record.data() + RECORD_PREFIX, record.size() - RECORD_PREFIX);
+    std::string crcBytes;
+    putLE32(crcBytes, crc);
+    record.replace(4, 4, crcBytes);
+
+    if (!writeAll(fd, record.data(), record.size()))
+    {
+        std::cerr << "❌ Block log write failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    fileLength += record.size();
+
+    ++unsynced;
+    if (syncEvery > 0 && unsynced >= syncEvery)
+        return syncLocked();
+    return true;
+}
+
+bool BlockLog::syncLocked()
+{
+    if (fd < 0 || unsynced == 0)
+        return true;
+    if (syncFd(fd) != 0)
+    {
+        std::cerr << "❌ Block log fsync failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    unsynced = 0;
+    writeSyncedLength(fileLength);
+    return true;
+}
+
+void BlockLog::encodeBlock(const Block &block, std::string &out)
+{
+    const BlockHeader &h = block.getHeader();
+    putLE32(out, static_cast<uint32_t>(h.index));
+    putLE64(out, static_cast<uint64_t>(h.timestamp));
+    putLE32(out, static_cast<uint32_t>(h.nonce));
+    putLE32(out, static_cast<uint32_t>(h.difficulty));
+    putHash(out, h.previousHash);
+    putHash(out, block.getHash());
+
+    const auto &txs = block.getTransactions();
+    putLE32(out, static_cast<uint32_t>(txs.size()));
+    for (const auto &tx : txs)
+    {
+        encodeTransaction(tx, out);
+    }
+}
+
+void BlockLog::encodeTransaction(const UTXOTransaction &tx, std::string &out)
+{
+    putHash(out, tx.getId());
+    putLE32(out, static_cast<uint32_t>(tx.getInputs().size()));
+    putLE32(out, static_cast<uint32_t>(tx.getOutputs().size()));
+    for (const auto &in : tx.getInputs())
+    {
+        putHash(out, in.txId);
+        putLE32(out, static_cast<uint32_t>(in.outputIndex));
+        putString(out, in.signature);
+    }
+    for (const auto &o : tx.getOutputs())
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &o.amount, sizeof(bits));
+        putLE64(out, bits);
+        putString(out, o.address);
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include "block.h"
+#include "chain_store.h"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// append-only 바이너리 블록 로그 (chain.log)
+//
+// 파일 구조 (모든 정수는 little-endian):
+//   header : "TCBLOCK\0" magic 8바이트 + uint32 version
+//   record : uint32 length | uint32 crc32(type + payload) | uint8 type | payload[length - 1]
+// 블록이 확정될 때마다 그 블록 하나만 레코드로 덧붙인다. 체인 전체를 다시 쓰지 않는다.
+// 시작할 때는 파일을 mmap하고 레코드 위치만 훑는다. 블록 내용은 ChainStore가 필요할 때 그 자리에서 읽는다.
+// 쓰다 만(잘렸거나 CRC가 맞지 않는) 꼬리 레코드는 잘라낸다.
+//
+// fsync가 끝난 길이는 옆 파일(<path>.synced: uint64 길이 + uint32 crc32)에 적어 둔다.
+// 이 값은 fsync 뒤에만 쓰므로 디스크에 남은 값은 실제로 내려간 길이보다 크지 않다.
+// 시작할 때는 그 뒤의 레코드만 CRC를 확인하고, 옆 파일이 없거나 맞지 않으면 전부 확인한다.
+class BlockLog
+{
+public:
+    enum RecordType : uint8_t
+    {
+        RECORD_BLOCK = 1,
+        RECORD_DIFFICULTY = 2, // 다음 블록 채굴 난이도 (int32)
+    };
+
+    // syncEvery: 레코드 N개마다 fdatasync (1 = 매번, 0 = OS에 맡김)
+    explicit BlockLog(const std::string &path, unsigned syncEvery = 1);
+    ~BlockLog();
+
+    BlockLog(const BlockLog &) = delete;
+    BlockLog &operator=(const BlockLog &) = delete;
+
+    // 파일을 열고(없으면 만든다) 매핑한 뒤 블록 레코드 위치를 모은다.
+    // fsync가 끝났다고 기록된 길이 뒤의 레코드만 CRC를 확인하고, 나머지는 읽힐 때 확인된다.
+    // difficulty는 마지막 DIFFICULTY 레코드가 있을 때만 바뀐다.
+    bool load(MappedBlocks &blocks, int &difficulty);
+
+    bool appendBlock(const Block &block);
+    bool appendDifficulty(int difficulty);
+    // 아직 fsync하지 않은 레코드를 디스크에 내린다
+    bool sync();
+
+    void setSyncEvery(unsigned records) { syncEvery = records; }
+    unsigned getSyncEvery() const { return syncEvery; }
+    bool isOpen() const { return fd >= 0; }
+    size_t getBlockCount() const { return blockCount; }
+    const std::string &getPath() const { return path; }
+
+    // 블록 레코드 payload 직렬화. 읽기는 BlockView가 한다.
+    static void encodeBlock(const Block &block, std::string &out);
+    // 블록 레코드 안의 트랜잭션 하나. 읽기는 TxView가 한다 (mempool 저장에도 쓴다)
+    static void encodeTransaction(const UTXOTransaction &tx, std::string &out);
+
+private:
+    std::string path;
+    int fd = -1;
+    int syncedFd = -1; // <path>.synced
+    unsigned syncEvery;
+    unsigned unsynced = 0;
+    size_t fileLength = 0; // 지금까지 쓴 길이
+    size_t blockCount = 0;
+    std::mutex mtx;
+
+    bool appendRecord(RecordType type, const std::string &payload);
+    bool syncLocked();
+    // 옆 파일에서 fsync가 끝난 길이를 읽는다. 없거나 손상됐으면 0
+    size_t readSyncedLength();
+    void writeSyncedLength(size_t length);
+};
+
+// CRC-32 (IEEE). 이어서 계산하려면 이전 결과를 crc로 넘긴다
+uint32_t computeCrc32(const void *data, size_t len, uint32_t crc = 0);
+
+#endif
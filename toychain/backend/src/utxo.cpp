@@ -1,7 +1,9 @@
 #include "utxo.h"
+#include "crypto.h"
+#include "byte_io.h"
+#include <cstring>
 #include <sstream>
-#include <iomanip>
-#include <openssl/sha.h>
+#include <stdexcept>
 
 UTXOTransaction::UTXOTransaction(const std::vector<TxInput> &ins, const std::vector<TxOutput> &outs)
     : inputs(ins), outputs(outs)
@@ -9,100 +11,276 @@ UTXOTransaction::UTXOTransaction(const std::vector<TxInput> &ins, const std::vec
     id = calculateHash();
 }
 
-UTXOTransaction::UTXOTransaction(const std::string &forcedId,
-                                 const std::vector<TxInput> &ins,
-                                 const std::vector<TxOutput> &outs)
-    : id(forcedId), inputs(ins), outputs(outs)
+UTXOTransaction::UTXOTransaction(const Hash256 &forcedId,
+                                 std::vector<TxInput> ins,
+                                 std::vector<TxOutput> outs)
+    : id(forcedId), inputs(std::move(ins)), outputs(std::move(outs))
 {
 }
-std::string UTXOTransaction::calculateHash() const
+Hash256 UTXOTransaction::calculateHash() const
+{
+    return sha256(serialize(inputs, outputs));
+}
+
+std::string UTXOTransaction::serialize(const std::vector<TxInput> &ins, const std::vector<TxOutput> &outs)
 {
     std::stringstream ss;
 
-    for (const auto &input : inputs)
+    for (const auto &input : ins)
     {
-        ss << input.txId << ":" << input.outputIndex << ":" << input.signature;
+        ss << input.txId.toHex() << ":" << input.outputIndex << ":" << input.signature;
     }
     ss << "|";
-    for (const auto &output : outputs)
+    for (const auto &output : outs)
     {
         ss << output.amount << ":" << output.address;
     }
 
-    std::string data = ss.str();
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    SHA256((unsigned char *)data.c_str(), data.size(), hash);
-
-    std::stringstream hashStr;
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++)
-    {
-        hashStr << std::hex << std::setw(2) << std::setfill('0') << (int)hash[i];
-    }
-
-    return hashStr.str();
+    return ss.str();
 }
 
 std::string UTXOTransaction::toString() const
 {
     std::stringstream ss;
-    ss << "TX[" << id.substr(0, 8) << "...] ";
+    ss << "TX[" << ::toHex(id.data(), 4) << "...] ";
     ss << "Inputs: " << inputs.size() << ", Outputs: " << outputs.size();
     return ss.str();
 }
 
 // UTXOSet implementation
-void UTXOSet::addUTXO(const std::string &txId, int index, const TxOutput &output)
+void UTXOSet::addUTXO(const OutPoint &outPoint, const TxOutput &output, UndoLog *undo)
+{
+    auto [record, inserted] = utxos.insert(outPoint);
+    if (undo)
+    {
+        undo->push_back(inserted ? UndoEntry{outPoint, false, TxOutput()}
+                                 : UndoEntry{outPoint, true, TxOutput(record->amount, addresses[record->addressId].address)});
+    }
+    if (!inserted)
+    {
+        indexRemove(*record);
+    }
+    indexAdd(*record, internAddress(output.address), output.amount);
+}
+
+bool UTXOSet::removeUTXO(const OutPoint &outPoint, UndoLog *undo)
 {
-    utxos[makeKey(txId, index)] = output;
+    const UTXORecord *record = utxos.find(outPoint);
+    if (!record)
+    {
+        return false;
+    }
+    if (undo)
+    {
+        undo->push_back(UndoEntry{outPoint, true, TxOutput(record->amount, addresses[record->addressId].address)});
+    }
+    indexRemove(*record);
+    utxos.erase(outPoint);
+    return true;
 }
 
-bool UTXOSet::removeUTXO(const std::string &txId, int index)
+void UTXOSet::rollback(const UndoLog &undo)
 {
-    return utxos.erase(makeKey(txId, index)) > 0;
+    for (auto it = undo.rbegin(); it != undo.rend(); ++it)
+    {
+        if (it->existed)
+        {
+            addUTXO(it->outPoint, it->previous);
+        }
+        else
+        {
+            removeUTXO(it->outPoint);
+        }
+    }
 }
 
-bool UTXOSet::hasUTXO(const std::string &txId, int index) const
+bool UTXOSet::hasUTXO(const OutPoint &outPoint) const
 {
-    return utxos.find(makeKey(txId, index)) != utxos.end();
+    return utxos.find(outPoint) != nullptr;
 }
 
-TxOutput UTXOSet::getUTXO(const std::string &txId, int index) const
+TxOutput UTXOSet::getUTXO(const OutPoint &outPoint) const
 {
-    return utxos.at(makeKey(txId, index));
+    const UTXORecord *record = utxos.find(outPoint);
+    if (!record)
+    {
+        throw std::out_of_range("UTXO not found");
+    }
+    return TxOutput(record->amount, addresses[record->addressId].address);
 }
 
 double UTXOSet::getBalance(const std::string &address) const
 {
-    double balance = 0.0;
-    for (const auto &[key, output] : utxos)
+    auto it = addressIds.find(address);
+    return it == addressIds.end() ? 0.0 : addresses[it->second].balance;
+}
+
+std::vector<std::pair<OutPoint, TxOutput>> UTXOSet::getUTXOsForAddress(const std::string &address) const
+{
+    std::vector<std::pair<OutPoint, TxOutput>> result;
+    auto it = addressIds.find(address);
+    if (it == addressIds.end())
     {
-        if (output.address == address)
-        {
-            balance += output.amount;
-        }
+        return result;
     }
-    return balance;
+    const AddressEntry &entry = addresses[it->second];
+    result.reserve(entry.outPoints.size());
+    for (const auto &outPoint : entry.outPoints)
+    {
+        result.emplace_back(outPoint, TxOutput(utxos.find(outPoint)->amount, entry.address));
+    }
+    return result;
 }
 
-std::vector<std::pair<std::string, TxOutput>> UTXOSet::getUTXOsForAddress(const std::string &address) const
+std::unordered_map<std::string, double> UTXOSet::getBalances() const
 {
-    std::vector<std::pair<std::string, TxOutput>> result;
-    for (const auto &[key, output] : utxos)
+    std::unordered_map<std::string, double> balances;
+    for (const auto &entry : addresses)
     {
-        if (output.address == address)
+        if (!entry.outPoints.empty())
         {
-            result.push_back({key, output});
+            balances[entry.address] = entry.balance;
         }
     }
+    return balances;
+}
+
+std::vector<std::pair<OutPoint, TxOutput>> UTXOSet::getAllUTXOs() const
+{
+    std::vector<std::pair<OutPoint, TxOutput>> result;
+    result.reserve(utxos.size());
+    utxos.forEach([&](const UTXORecord &record)
+                  { result.emplace_back(record.outPoint, TxOutput(record.amount, addresses[record.addressId].address)); });
     return result;
 }
 
-std::unordered_map<std::string, TxOutput> UTXOSet::getAllUTXOs() const
+void UTXOSet::serialize(std::string &out) const
 {
-    return utxos;
+    putLE32(out, static_cast<uint32_t>(addresses.size()));
+    for (const auto &entry : addresses)
+    {
+        putLE32(out, static_cast<uint32_t>(entry.address.size()));
+        out.append(entry.address);
+        uint64_t bits;
+        std::memcpy(&bits, &entry.balance, sizeof(bits));
+        putLE64(out, bits);
+    }
+
+    putLE64(out, utxos.size());
+    out.reserve(out.size() + utxos.size() * 48);
+    utxos.forEach([&](const UTXORecord &record)
+                  {
+        out.append(reinterpret_cast<const char *>(record.outPoint.txId.data()), Sha256::DIGEST_SIZE);
+        putLE32(out, record.outPoint.index);
+        putLE32(out, record.addressId);
+        uint64_t bits;
+        std::memcpy(&bits, &record.amount, sizeof(bits));
+        putLE64(out, bits); });
+}
+
+void UTXOSet::deserialize(const unsigned char *data, size_t len)
+{
+    const unsigned char *p = data;
+    const unsigned char *end = data + len;
+    auto need = [&](size_t n)
+    {
+        if (static_cast<size_t>(end - p) < n)
+            throw std::runtime_error("truncated UTXO snapshot");
+    };
+
+    *this = UTXOSet();
+
+    need(4);
+    uint32_t addressCount = loadLE32(p);
+    p += 4;
+    std::vector<double> balances;
+    for (uint32_t i = 0; i < addressCount; ++i)
+    {
+        need(4);
+        uint32_t n = loadLE32(p);
+        p += 4;
+        need(n + 8);
+        internAddress(std::string(reinterpret_cast<const char *>(p), n));
+        uint64_t bits = loadLE64(p + n);
+        double balance;
+        std::memcpy(&balance, &bits, sizeof(balance));
+        balances.push_back(balance);
+        p += n + 8;
+    }
+    if (addresses.size() != addressCount)
+        throw std::runtime_error("duplicate address in UTXO snapshot");
+
+    need(8);
+    uint64_t count = loadLE64(p);
+    p += 8;
+    if (count > static_cast<uint64_t>(end - p) / 48)
+        throw std::runtime_error("truncated UTXO snapshot");
+    utxos.reserve(static_cast<size_t>(count));
+    for (uint64_t i = 0; i < count; ++i, p += 48)
+    {
+        OutPoint outPoint;
+        std::memcpy(outPoint.txId.data(), p, Sha256::DIGEST_SIZE);
+        outPoint.index = loadLE32(p + 32);
+        uint32_t addressId = loadLE32(p + 36);
+        if (addressId >= addressCount)
+            throw std::runtime_error("bad address id in UTXO snapshot");
+        uint64_t bits = loadLE64(p + 40);
+        double amount;
+        std::memcpy(&amount, &bits, sizeof(amount));
+
+        auto [record, inserted] = utxos.insert(outPoint);
+        if (!inserted)
+            throw std::runtime_error("duplicate outpoint in UTXO snapshot");
+        indexAdd(*record, addressId, amount);
+    }
+    if (p != end)
+        throw std::runtime_error("trailing bytes in UTXO snapshot");
+
+    // 잔액은 누적 순서에 따라 부동소수 오차가 달라지므로 저장된 값을 그대로 쓴다
+    for (uint32_t i = 0; i < addressCount; ++i)
+        addresses[i].balance = addresses[i].outPoints.empty() ? 0.0 : balances[i];
 }
 
-std::string UTXOSet::makeKey(const std::string &txId, int index) const
+uint32_t UTXOSet::internAddress(const std::string &address)
 {
-    return txId + ":" + std::to_string(index);
+    auto [it, inserted] = addressIds.try_emplace(address, static_cast<uint32_t>(addresses.size()));
+    if (inserted)
+    {
+        addresses.push_back(AddressEntry{address, {}, 0.0});
+    }
+    return it->second;
+}
+
+void UTXOSet::indexAdd(UTXORecord &record, uint32_t addressId, double amount)
+{
+    record.addressId = addressId;
+    record.amount = amount;
+
+    AddressEntry &entry = addresses[record.addressId];
+    record.addressSlot = static_cast<uint32_t>(entry.outPoints.size());
+    entry.outPoints.push_back(record.outPoint);
+    entry.balance += amount;
+}
+
+void UTXOSet::indexRemove(const UTXORecord &record)
+{
+    AddressEntry &entry = addresses[record.addressId];
+
+    // 마지막 outpoint를 빈자리로 옮기고 그 레코드의 위치를 갱신한다
+    const OutPoint last = entry.outPoints.back();
+    entry.outPoints.pop_back();
+    if (record.addressSlot < entry.outPoints.size())
+    {
+        entry.outPoints[record.addressSlot] = last;
+        utxos.find(last)->addressSlot = record.addressSlot;
+    }
+
+    if (entry.outPoints.empty())
+    {
+        entry.balance = 0.0; // 부동소수 누적 오차를 남기지 않도록 비면 0으로
+    }
+    else
+    {
+        entry.balance -= record.amount;
+    }
 }
@@ -1,18 +1,23 @@
 #ifndef UTXO_H
 #define UTXO_H
 
+#include "crypto.h"
+#include "flat_utxo_map.h"
 #include <string>
 #include <vector>
 #include <unordered_map>
 
 struct TxInput
 {
-    std::string txId;      // 참조하는 이전 트랜잭션 ID
+    Hash256 txId;          // 참조하는 이전 트랜잭션 ID
     int outputIndex;       // 해당 트랜잭션의 몇 번째 output인지
     std::string signature; // 서명 (간단히 address로 대체)
 
-    TxInput(const std::string &id, int idx, const std::string &sig)
+    TxInput(const Hash256 &id, int idx, const std::string &sig)
         : txId(id), outputIndex(idx), signature(sig) {}
+
+    // coinbase dummy input(outputIndex < 0)에는 의미가 없다
+    OutPoint outPoint() const { return OutPoint(txId, static_cast<uint32_t>(outputIndex)); }
 };
 
 struct TxOutput
@@ -28,40 +33,77 @@ struct TxOutput
 class UTXOTransaction
 {
 private:
-    std::string id;
+    Hash256 id;
     std::vector<TxInput> inputs;
     std::vector<TxOutput> outputs;
 
 public:
     UTXOTransaction(const std::vector<TxInput> &ins, const std::vector<TxOutput> &outs);
-    UTXOTransaction(const std::string &forcedId, const std::vector<TxInput> &ins, const std::vector<TxOutput> &outs);
+    UTXOTransaction(const Hash256 &forcedId, std::vector<TxInput> ins, std::vector<TxOutput> outs);
 
-    std::string getId() const { return id; }
+    const Hash256 &getId() const { return id; }
     const std::vector<TxInput> &getInputs() const { return inputs; }
     const std::vector<TxOutput> &getOutputs() const { return outputs; }
 
-    std::string calculateHash() const;
+    Hash256 calculateHash() const;
     std::string toString() const;
+
+    // id 계산에 쓰이는 직렬화 (여러 트랜잭션을 Sha256::hashMany로 묶어 계산할 때 사용)
+    static std::string serialize(const std::vector<TxInput> &ins, const std::vector<TxOutput> &outs);
 };
 
 class UTXOSet
 {
 private:
-    // key: txId:outputIndex, value: TxOutput
-    std::unordered_map<std::string, TxOutput> utxos;
+    // outpoint → {금액, 주소 id}. 노드 할당 없는 flat 테이블에 인라인으로 보관한다.
+    FlatUTXOMap utxos;
+
+    // 주소는 한 번만 저장하고 id로 참조한다.
+    // 주소별로 가진 outpoint 목록과 잔액 합계를 함께 관리하므로 주소 조회 비용은 그 주소의 UTXO 수에만 비례한다.
+    struct AddressEntry
+    {
+        std::string address;
+        std::vector<OutPoint> outPoints; // UTXORecord::addressSlot이 이 안의 위치를 가리킨다
+        double balance = 0.0;
+    };
+    std::vector<AddressEntry> addresses;
+    std::unordered_map<std::string, uint32_t> addressIds;
 
 public:
-    void addUTXO(const std::string &txId, int index, const TxOutput &output);
-    bool removeUTXO(const std::string &txId, int index);
-    bool hasUTXO(const std::string &txId, int index) const;
-    TxOutput getUTXO(const std::string &txId, int index) const;
+    // 변경 전 상태를 기록하는 undo journal. 역순으로 되돌리면 적용 이전 상태가 된다.
+    struct UndoEntry
+    {
+        OutPoint outPoint;
+        bool existed;      // 변경 전에 이 outpoint가 있었는지
+        TxOutput previous; // existed일 때의 이전 값
+    };
+    using UndoLog = std::vector<UndoEntry>;
+
+    // undo가 주어지면 바뀌기 전 상태를 거기에 덧붙인다
+    void addUTXO(const OutPoint &outPoint, const TxOutput &output, UndoLog *undo = nullptr);
+    bool removeUTXO(const OutPoint &outPoint, UndoLog *undo = nullptr);
+    // undo에 기록된 변경을 역순으로 되돌린다
+    void rollback(const UndoLog &undo);
+    bool hasUTXO(const OutPoint &outPoint) const;
+    // 없으면 std::out_of_range
+    TxOutput getUTXO(const OutPoint &outPoint) const;
 
     double getBalance(const std::string &address) const;
-    std::vector<std::pair<std::string, TxOutput>> getUTXOsForAddress(const std::string &address) const;
-    std::unordered_map<std::string, TxOutput> getAllUTXOs() const;
+    std::vector<std::pair<OutPoint, TxOutput>> getUTXOsForAddress(const std::string &address) const;
+    std::unordered_map<std::string, double> getBalances() const;
+    std::vector<std::pair<OutPoint, TxOutput>> getAllUTXOs() const;
+    size_t size() const { return utxos.size(); }
+    size_t memoryUsage() const { return utxos.memoryUsage(); }
+
+    // 스냅샷용 직렬화: 주소 테이블(주소, 잔액) 뒤에 outpoint당 48바이트 레코드
+    void serialize(std::string &out) const;
+    // 현재 내용을 버리고 serialize 결과로 채운다. 형식이 맞지 않으면 std::runtime_error
+    void deserialize(const unsigned char *data, size_t len);
 
 private:
-    std::string makeKey(const std::string &txId, int index) const;
+    uint32_t internAddress(const std::string &address);
+    void indexAdd(UTXORecord &record, uint32_t addressId, double amount);
+    void indexRemove(const UTXORecord &record);
 };
 
 #endif
@@ -0,0 +1,38 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 고정 개수의 스레드가 작업 큐를 나눠 처리한다.
+// 이벤트 루프가 막히면 안 되는 일(채굴, 블록 검증, 피어 전파 등)을 여기로 넘긴다.
+class WorkerPool
+{
+public:
+    explicit WorkerPool(unsigned threads);
+    // 남은 작업을 모두 처리한 뒤 스레드를 끝낸다
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    void submit(std::function<void()> task);
+    // 소멸자와 같지만 소멸 전에 부를 수 있다. 이후에 넣은 작업은 실행되지 않는다
+    void shutdown();
+    size_t size() const { return workers.size(); }
+
+private:
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> tasks;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+
+    void run();
+};
+
+#endif
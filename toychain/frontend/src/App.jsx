@@ -216,6 +216,11 @@ function App() {
         miningStreamRef.current.close();
         miningStreamRef.current = null;
       }
+      if (miningJobRef.current) {
+        // the previous job would otherwise keep its place in the server's mining queue
+        fetch(`${API_BASE}/mine/cancel?id=${miningJobRef.current}`, { method: "POST" }).catch(() => {});
+        miningJobRef.current = null;
+      }
       const res = await fetch(`${API_BASE}/mine/start`, {
         method: "POST",
         headers: { "Content-Type": "application/json" },
@@ -234,13 +239,13 @@ function App() {
         try {
           const status = JSON.parse(evt.data);
           if (Array.isArray(status.attempts)) {
-            setMiningAttempts(
-              status.attempts.map((h, idx) => ({
-                hash: h.includes(":") ? h.split(":")[1] : h,
-                nonce: h.includes(":") ? h.split(":")[0] : "",
-                success: status.status === "done" && idx === status.attempts.length - 1,
-              }))
-            );
+            // each event carries only the samples since the previous one
+            const fresh = status.attempts.map((h, idx) => ({
+              hash: h.includes(":") ? h.split(":")[1] : h,
+              nonce: h.includes(":") ? h.split(":")[0] : "",
+              success: status.status === "done" && idx === status.attempts.length - 1,
+            }));
+            setMiningAttempts((prev) => [...prev, ...fresh].slice(-100));
           }
           if (status.status === "done") {
             if (miningStreamRef.current) {
@@ -258,6 +263,9 @@ function App() {
               setMiningAttempts([]);
               setFinalHash("");
             }, 3000);
+          } else if (status.status === "cancelled") {
+            setBanner({ type: "error", text: "Mining cancelled" });
+            stopMiningStream({ clearAttempts: false });
           } else if (status.status === "error") {
             throw new Error(status.message || "Mining failed");
           }